@@ -5,7 +5,10 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdarg.h>
+#include <math.h>
 #include <openssl/sha.h>
 #include <sys/stat.h>
 #include <pwd.h>
+#include <pthread.h>
 #include "json.h"
\ No newline at end of file
@@ -46,10 +46,33 @@ static void serializeChildCallback(void *cookie, char *key, LCObjectRef objects[
   fprintf(info->fp, "]");
 }
 
+static void writeJsonEscaped(FILE *fpw, LCByte text[], size_t length) {
+  size_t start = 0;
+  for (size_t i=0; i<length; i++) {
+    if (text[i] != '"' && text[i] != '\\' && text[i] >= 0x20) {
+      continue;
+    }
+    fwrite(&text[start], sizeof(LCByte), i - start, fpw);
+    if (text[i] == '"' || text[i] == '\\') {
+      fprintf(fpw, "\\%c", text[i]);
+    } else {
+      fprintf(fpw, "\\u%04x", text[i]);
+    }
+    start = i + 1;
+  }
+  fwrite(&text[start], sizeof(LCByte), length - start, fpw);
+}
+
+// the text is escaped, so quotes, backslashes and control characters such as NULs survive as json
 void objectSerializeTextToJson(LCObjectRef object, FILE *fpw) {
+  LCMutableDataRef text = LCMutableDataCreate(NULL, 0);
+  FILE *textStream = createMemoryWriteStream(text, LCMutableDataAppendAlt, NULL);
+  objectSerializeBinaryData(object, textStream);
+  fclose(textStream);
   fprintf(fpw, "\"");
-  objectSerializeBinaryData(object, fpw);
+  writeJsonEscaped(fpw, LCMutableDataDataRef(text), LCMutableDataLength(text));
   fprintf(fpw, "\"");
+  objectRelease(text);
 }
 
 void objectSerializeJsonToLevels(LCObjectRef object, LCInteger levels, FILE *fpw, walkChildren walkFun) {
@@ -64,6 +87,47 @@ void objectSerializeJsonToLevels(LCObjectRef object, LCInteger levels, FILE *fpw
   fprintf(fpw, "}");
 }
 
+static void serializeMetaChildCallback(void *cookie, char *key, LCObjectRef objects[], size_t length, bool composite) {
+  struct LCSerializationCookie *info = (struct LCSerializationCookie*)cookie;
+  if (info->first) {
+    info->first = false;
+  } else {
+    fprintf(info->fp, ",\n");
+  }
+  fprintf(info->fp, "\"%s\": [", key);
+  for (LCInteger i=0; i<length; i++) {
+    fprintf(info->fp, i > 0 ? ", {" : "{");
+    bool first = true;
+    for (LCInteger metaKey=0; metaKey<LCMetaKeysCount && objects[i] && objectType(objects[i])->immutable; metaKey++) {
+      uint64_t value;
+      if (objectReferenceMeta(objects[i], metaKey, &value)) {
+        // written as signed so the json parser reads sort keys with the top bit set back unchanged
+        fprintf(info->fp, "%s\"%s\": %lld", first ? "" : ", ", objectMetaKeyName(metaKey), (long long)(int64_t)value);
+        first = false;
+      }
+    }
+    fprintf(info->fp, "}");
+  }
+  fprintf(info->fp, "]");
+}
+
+/*
+ writes the meta the children of object know as one json object per child, in the order walkFun
+ reports them; it is kept apart from the object's own serialization so its digest stays the hash
+ of what is stored under it
+*/
+void objectSerializeReferenceMeta(LCObjectRef object, FILE *fpw, walkChildren walkFun) {
+  struct LCSerializationCookie cookie = {
+    .fp = fpw,
+    .object = object,
+    .first = true,
+    .levels = 0
+  };
+  fprintf(fpw, "{");
+  walkFun(object, &cookie, serializeMetaChildCallback);
+  fprintf(fpw, "}");
+}
+
 void objectSerializeJson(LCObjectRef object, bool composite, FILE *fpw, walkChildren walkFun) {
   if (composite) {
     objectSerializeJsonToLevels(object, -1, fpw, walkFun);
@@ -74,7 +138,8 @@ void objectSerializeJson(LCObjectRef object, bool composite, FILE *fpw, walkChil
 
 static void objectDeserializeBinaryDataFromJson(LCObjectRef object, json_value *children) {
   char *dataStringJson = children->u.string.ptr;
-  objectDeserializeBinaryData(object, createMemoryReadStream(NULL, (LCByte*)dataStringJson, strlen(dataStringJson)+1, false, NULL));
+  objectDeserializeBinaryData(object, createMemoryReadStream(NULL, (LCByte*)dataStringJson, children->u.string.length,
+                                                             false, NULL));
 }
 
 static void objectDeserializeObjectDataFromJson(LCObjectRef object, json_value *json) {
@@ -151,14 +216,36 @@ LCObjectRef objectCreateFromJson(json_value *json, LCContextRef context) {
 
 void objectDeserializeJsonFile(LCObjectRef object, FILE *fd) {
   json_value *json = fileToJson(fd);
-  json_value *children = NULL;
-  for (LCInteger k=0; k<json->u.object.length; k++) {
-    char* objectInfoKey = json->u.object.values[k].name;
-    json_value *objectInfoValue = json->u.object.values[k].value;
-    if (strcmp(objectInfoKey, "data")==0) {
-      children = objectInfoValue;
+  objectDeserializeDataFromJson(object, json);
+  json_value_free(json);
+}
+
+static void deserializeMetaChildCallback(void *cookie, char *key, LCObjectRef objects[], size_t length, bool composite) {
+  json_value *json = cookie;
+  json_value *metas = NULL;
+  for (LCInteger i=0; i<json->u.object.length; i++) {
+    if (strcmp(json->u.object.values[i].name, key)==0 && json->u.object.values[i].value->type == json_array) {
+      metas = json->u.object.values[i].value;
     }
   }
-  objectDeserializeDataFromJson(object, children);
+  for (LCInteger i=0; metas && i<length && i<metas->u.array.length; i++) {
+    json_value *meta = metas->u.array.values[i];
+    for (LCInteger k=0; objects[i] && meta->type == json_object && k<meta->u.object.length; k++) {
+      json_value *value = meta->u.object.values[k].value;
+      for (LCInteger metaKey=0; metaKey<LCMetaKeysCount && value->type == json_integer; metaKey++) {
+        if (strcmp(meta->u.object.values[k].name, objectMetaKeyName(metaKey))==0) {
+          objectSetStubMeta(objects[i], metaKey, (uint64_t)value->u.integer);
+        }
+      }
+    }
+  }
+}
+
+// hands the meta objectSerializeReferenceMeta wrote to the stubs among the children of object
+void objectDeserializeReferenceMeta(LCObjectRef object, FILE *fd, walkChildren walkFun) {
+  json_value *json = fileToJson(fd);
+  if (json && json->type == json_object) {
+    walkFun(object, json, deserializeMetaChildCallback);
+  }
   json_value_free(json);
 }
@@ -7,7 +7,9 @@
 void objectSerializeTextToJson(LCObjectRef object, FILE *fpw);
 void objectSerializeJsonToLevels(LCObjectRef object, LCInteger levels, FILE *fp, walkChildren walkFun);
 void objectSerializeJson(LCObjectRef object, bool composite, FILE *fp, walkChildren walkFun);
+void objectSerializeReferenceMeta(LCObjectRef object, FILE *fp, walkChildren walkFun);
 LCObjectRef objectCreateFromJsonFile(FILE *fd, LCContextRef context);
 void objectDeserializeJsonFile(LCObjectRef object, FILE *fd);
+void objectDeserializeReferenceMeta(LCObjectRef object, FILE *fd, walkChildren walkFun);
 
 #endif
@@ -1,21 +1,27 @@
 
 #include "LCArray.h"
+#include "LCUtils.h"
+
+#define ARRAY_PARALLEL_MIN_CHUNK 1024
 
 typedef struct arrayData* arrayDataRef;
 
 LCCompare arrayCompare(LCObjectRef object1, LCObjectRef object2);
 void arrayDealloc(LCObjectRef object);
+size_t arrayDataSize(LCObjectRef object);
 void arrayWalkChildren(LCObjectRef object, void *cookie, childCallback cb);
+void arrayWalkReferences(LCObjectRef object, void *cookie, childCallback cb);
 void arrayStoreChildren(LCObjectRef object, char *key, LCObjectRef objects[], size_t length);
 static void* arrayInitData();
 
 bool resizeBuffer(arrayDataRef array, size_t size);
 void mutableArraySerialize(LCObjectRef object, void* cookie, callback flush, FILE* fd);
 
-struct arrayData {
+struct arrayBuffer {
+  LCInteger rCount;
   size_t length;
-  size_t bufferLength;
-  LCObjectRef* objects;
+  size_t capacity;
+  LCObjectRef objects[];
 };
 
 struct LCType typeArray = {
@@ -24,8 +30,11 @@ struct LCType typeArray = {
   .immutable = true,
   .dealloc = arrayDealloc,
   .compare = arrayCompare,
+  .dataSize = arrayDataSize,
+  .length = LCArrayLength,
   .initData = arrayInitData,
   .walkChildren = arrayWalkChildren,
+  .walkReferences = arrayWalkReferences,
   .storeChildren = arrayStoreChildren
 };
 
@@ -35,8 +44,11 @@ struct LCType typeMutableArray = {
   .immutable = false,
   .dealloc = arrayDealloc,
   .compare = arrayCompare,
+  .dataSize = arrayDataSize,
+  .length = LCArrayLength,
   .initData = arrayInitData,
   .walkChildren = arrayWalkChildren,
+  .walkReferences = arrayWalkReferences,
   .storeChildren = arrayStoreChildren
 };
 
@@ -47,23 +59,78 @@ static void* arrayInitData() {
   arrayDataRef newArray = malloc(sizeof(struct arrayData));
   if (newArray) {
     newArray->length = 0;
-    newArray->objects = NULL;
+    newArray->bufferLength = LC_ARRAY_INLINE_LENGTH;
+    newArray->objects = newArray->inlineObjects;
+    newArray->buffer = NULL;
   }
   return newArray;
 }
 
+static LCInteger arrayBufferRetainCount(struct arrayBuffer *buffer) {
+  return __atomic_load_n(&buffer->rCount, __ATOMIC_ACQUIRE);
+}
+
+// the buffer count follows the object counts, it is atomic in LCReleaseBackground
+static void arrayBufferRelease(struct arrayBuffer *buffer) {
+  if (retainCountAdd(&buffer->rCount, -1) == 0) {
+    for (LCInteger i=0; i<buffer->length; i++) {
+      objectRelease(buffer->objects[i]);
+    }
+    lcFree(buffer);
+  }
+}
+
+// only arrays that own their storage may write to it, everything else copies first
+static bool arrayOwnsStorage(arrayDataRef array) {
+  if (array->objects == array->inlineObjects) {
+    return true;
+  }
+  return array->buffer && arrayBufferRetainCount(array->buffer) == 1 && array->objects == array->buffer->objects &&
+    array->length == array->buffer->length;
+}
+
+static void arraySetLength(arrayDataRef array, size_t length) {
+  array->length = length;
+  if (array->buffer) {
+    array->buffer->length = length;
+  }
+}
+
 static void arraySetObjects(arrayDataRef data, LCObjectRef objects[], size_t length) {
+  if (length == 0 || !resizeBuffer(data, length)) {
+    return;
+  }
   for(LCInteger i=0; i<length; i++) {
     objectRetain(objects[i]);
   }
-  resizeBuffer(data, length);
   memcpy(data->objects, objects, length * sizeof(LCObjectRef));
-  data->length = length;
+  arraySetLength(data, length);
+}
+
+// views into a shared buffer keep the whole buffer alive, inline and static storage is copied
+static arrayDataRef arrayDataCreateView(arrayDataRef source, size_t start, size_t length) {
+  arrayDataRef data = arrayInitData();
+  if (!data) {
+    return NULL;
+  }
+  if (source->buffer) {
+    retainCountAdd(&source->buffer->rCount, 1);
+    data->buffer = source->buffer;
+    data->objects = &(source->objects[start]);
+    data->length = length;
+    data->bufferLength = length;
+  } else {
+    arraySetObjects(data, &(source->objects[start]), length);
+  }
+  return data;
+}
+
+static arrayDataRef arrayDataCreateSharing(arrayDataRef source) {
+  return arrayDataCreateView(source, 0, source->length);
 }
 
 LCArrayRef LCArrayCreate(LCObjectRef objects[], size_t length) {
   arrayDataRef newArray = arrayInitData();
-  newArray->objects = NULL;
   arraySetObjects(newArray, objects, length);
   return objectCreate(LCTypeArray, newArray);
 };
@@ -79,18 +146,17 @@ LCArrayRef LCArrayCreateAppendingObjects(LCArrayRef object, LCObjectRef objects[
   }
   arrayDataRef array = objectData(object);
   size_t totalLength = array->length + length;
-  LCObjectRef* newObjects = malloc(totalLength * sizeof(LCObjectRef));
-  if(newObjects) {
-    memcpy(newObjects, array->objects, array->length * sizeof(LCObjectRef));
-    memcpy(&(newObjects[array->length]), objects, length * sizeof(LCObjectRef));
-    arrayDataRef data = arrayInitData();
-    data->objects = newObjects;
-    data->length = totalLength;
+  arrayDataRef data = arrayInitData();
+  if(data && resizeBuffer(data, totalLength)) {
+    memcpy(data->objects, array->objects, array->length * sizeof(LCObjectRef));
+    memcpy(&(data->objects[array->length]), objects, length * sizeof(LCObjectRef));
+    arraySetLength(data, totalLength);
     for (LCInteger i=0; i<totalLength; i++) {
-      objectRetain(newObjects[i]);
+      objectRetain(data->objects[i]);
     }
     return objectCreate(LCTypeArray, data);
   } else {
+    lcFree(data);
     return NULL;
   }
 }
@@ -101,11 +167,9 @@ LCArrayRef LCArrayCreateFromArrays(LCArrayRef arrays[], size_t length) {
     totalLength = totalLength + LCArrayLength(arrays[i]);
   }
   
-  LCObjectRef* newObjects = malloc(totalLength * sizeof(LCObjectRef));
-  if (newObjects) {
-    arrayDataRef newArray = arrayInitData();
-    newArray->objects = newObjects;
-    newArray->length = totalLength;
+  arrayDataRef newArray = arrayInitData();
+  if (newArray && resizeBuffer(newArray, totalLength)) {
+    arraySetLength(newArray, totalLength);
     size_t copyPos = 0;
     for (LCInteger i=0; i<length; i++) {
       size_t copyLength = LCArrayLength(arrays[i]);
@@ -117,6 +181,7 @@ LCArrayRef LCArrayCreateFromArrays(LCArrayRef arrays[], size_t length) {
     }
     return objectCreate(LCTypeArray, newArray);
   } else {
+    lcFree(newArray);
     return NULL;
   }
 }
@@ -132,34 +197,166 @@ LCObjectRef LCArrayObjectAtIndex(LCArrayRef object, LCInteger index) {
 }
 
 size_t LCArrayLength(LCArrayRef object) {
+  uint64_t length;
+  if (objectStubMeta(object, LCMetaLength, &length)) {
+    return length;
+  }
   arrayDataRef array = objectData(object);
   return array->length;
 }
 
 LCArrayRef LCArrayCreateSubArray(LCArrayRef object, LCInteger start, size_t length) {
-  size_t arrayLength = LCArrayLength(object);
-  LCObjectRef* arrayObjects = LCArrayObjects(object);
-  if (start >= arrayLength) {
+  arrayDataRef array = objectData(object);
+  if (start >= array->length) {
     return LCArrayCreate(NULL, 0);
   }
-  if (length == -1) {
-    length = arrayLength - start;
+  if (length == -1 || start + length > array->length) {
+    length = array->length - start;
+  }
+  return objectCreate(LCTypeArray, arrayDataCreateView(array, start, length));
+}
+
+struct arrayParallelInfo {
+  LCObjectRef *objects;
+  LCObjectRef *results;
+  bool *selected;
+  void *info;
+  LCCreateEachCb map;
+  LCFilterEachCb filter;
+  LCReduceCb reduce;
+  LCByte *accumulators;
+  size_t accumulatorSize;
+};
+
+static void arrayMapChunk(void *cookie, LCInteger chunk, size_t start, size_t end) {
+  struct arrayParallelInfo *parallelInfo = cookie;
+  for (size_t i=start; i<end; i++) {
+    parallelInfo->results[i] = parallelInfo->map(i, parallelInfo->info, parallelInfo->objects[i]);
+  }
+}
+
+static void arrayFilterChunk(void *cookie, LCInteger chunk, size_t start, size_t end) {
+  struct arrayParallelInfo *parallelInfo = cookie;
+  for (size_t i=start; i<end; i++) {
+    parallelInfo->selected[i] = parallelInfo->filter(i, parallelInfo->info, parallelInfo->objects[i]);
   }
-  return LCArrayCreate(&(arrayObjects[start]), length);
+}
+
+static void arrayReduceChunk(void *cookie, LCInteger chunk, size_t start, size_t end) {
+  struct arrayParallelInfo *parallelInfo = cookie;
+  void *accumulator = &(parallelInfo->accumulators[chunk * parallelInfo->accumulatorSize]);
+  for (size_t i=start; i<end; i++) {
+    parallelInfo->reduce(i, parallelInfo->info, accumulator, parallelInfo->objects[i]);
+  }
+}
+
+// the map results are moved into the new array without another retain
+static LCObjectRef arrayCreateWithMap(LCTypeRef type, LCArrayRef array, void* info, LCCreateEachCb each, bool parallel) {
+  arrayDataRef source = objectData(array);
+  size_t length = source->length;
+  arrayDataRef data = arrayInitData();
+  if (!data || !resizeBuffer(data, length)) {
+    lcFree(data);
+    return NULL;
+  }
+  struct arrayParallelInfo parallelInfo = {
+    .objects = source->objects,
+    .results = data->objects,
+    .info = info,
+    .map = each
+  };
+  if (parallel) {
+    objectsPin(source->objects, length);
+    parallelFor(length, ARRAY_PARALLEL_MIN_CHUNK, &parallelInfo, arrayMapChunk);
+    objectsUnpin(source->objects, length);
+  } else {
+    arrayMapChunk(&parallelInfo, 0, 0, length);
+  }
+  arraySetLength(data, length);
+  return objectCreate(type, data);
 }
 
 LCArrayRef LCArrayCreateArrayWithMap(LCArrayRef array, void* info, LCCreateEachCb each) {
-  size_t arrayLength = LCArrayLength(array);
-  LCArrayRef* arrayObjects = LCArrayObjects(array);
-  LCArrayRef newObjects[arrayLength];
-  for (LCInteger i=0; i<arrayLength; i++) {
-    newObjects[i] = each(i, info, arrayObjects[i]);
+  return arrayCreateWithMap(LCTypeArray, array, info, each, false);
+}
+
+/*
+ the parallel functions split the array into consecutive ranges that are processed on separate threads,
+ so the callbacks run concurrently and must be thread safe: they may read any object but must not mutate
+ shared state, and since retain counts are not atomic they must not retain or release objects that other
+ calls may touch at the same time; results keep the order of the array. The elements are loaded and
+ pinned for the duration of the call, objects the callbacks reach through them must already be loaded if
+ their context has a cache budget
+*/
+LCArrayRef LCArrayCreateArrayWithParallelMap(LCArrayRef array, void* info, LCCreateEachCb each) {
+  return arrayCreateWithMap(LCTypeArray, array, info, each, true);
+}
+
+LCArrayRef LCArrayCreateArrayWithParallelFilter(LCArrayRef array, void* info, LCFilterEachCb each) {
+  arrayDataRef source = objectData(array);
+  size_t length = source->length;
+  bool *selected = malloc(sizeof(bool) * (length ? length : 1));
+  LCObjectRef *objects = malloc(sizeof(LCObjectRef) * (length ? length : 1));
+  if (!selected || !objects) {
+    perror("LCArrayCreateArrayWithParallelFilter");
+    lcFree(selected);
+    lcFree(objects);
+    return NULL;
   }
-  LCArrayRef newArray = LCArrayCreate(newObjects, arrayLength);
-  for (LCInteger i=0; i<arrayLength; i++) {
-    objectRelease(newObjects[i]);
+  struct arrayParallelInfo parallelInfo = {
+    .objects = source->objects,
+    .selected = selected,
+    .info = info,
+    .filter = each
+  };
+  objectsPin(source->objects, length);
+  parallelFor(length, ARRAY_PARALLEL_MIN_CHUNK, &parallelInfo, arrayFilterChunk);
+  objectsUnpin(source->objects, length);
+  size_t selectedLength = 0;
+  for (size_t i=0; i<length; i++) {
+    if (selected[i]) {
+      objects[selectedLength] = source->objects[i];
+      selectedLength++;
+    }
   }
-  return newArray;
+  LCArrayRef filtered = LCArrayCreate(objects, selectedLength);
+  lcFree(objects);
+  lcFree(selected);
+  return filtered;
+}
+
+/*
+ every range starts with its own copy of the accumulatorSize bytes at accumulator and folds its elements
+ into it with each, the copies are then merged in array order into accumulator with combine
+*/
+void LCArrayParallelReduce(LCArrayRef array, void* info, void *accumulator, size_t accumulatorSize,
+                           LCReduceCb each, LCCombineCb combine) {
+  arrayDataRef source = objectData(array);
+  size_t length = source->length;
+  size_t chunks = parallelChunkCount(length, ARRAY_PARALLEL_MIN_CHUNK);
+  LCByte *accumulators = malloc(accumulatorSize * chunks);
+  if (!accumulators) {
+    perror("LCArrayParallelReduce");
+    return;
+  }
+  for (size_t i=0; i<chunks; i++) {
+    memcpy(&accumulators[i * accumulatorSize], accumulator, accumulatorSize);
+  }
+  struct arrayParallelInfo parallelInfo = {
+    .objects = source->objects,
+    .info = info,
+    .reduce = each,
+    .accumulators = accumulators,
+    .accumulatorSize = accumulatorSize
+  };
+  objectsPin(source->objects, length);
+  parallelFor(length, ARRAY_PARALLEL_MIN_CHUNK, &parallelInfo, arrayReduceChunk);
+  objectsUnpin(source->objects, length);
+  memcpy(accumulator, accumulators, accumulatorSize);
+  for (size_t i=1; i<chunks; i++) {
+    combine(info, accumulator, &accumulators[i * accumulatorSize]);
+  }
+  lcFree(accumulators);
 }
 
 LCCompare arrayCompare(LCObjectRef array1, LCObjectRef array2) {
@@ -186,17 +383,40 @@ LCCompare arrayCompare(LCObjectRef array1, LCObjectRef array2) {
   return result;
 }
 
+// shared buffers are counted in full by every array using them
+size_t arrayDataSize(LCObjectRef object) {
+  arrayDataRef array = objectData(object);
+  if (array->buffer) {
+    return sizeof(struct arrayData) + sizeof(struct arrayBuffer) + sizeof(LCObjectRef) * array->buffer->capacity;
+  }
+  return sizeof(struct arrayData);
+}
+
 void arrayDealloc(LCObjectRef object) {
-  for (LCInteger i=0; i<LCArrayLength(object); i++) {
-    objectRelease(LCArrayObjectAtIndex(object, i));
+  arrayDataRef array = objectData(object);
+  if (array->buffer) {
+    arrayBufferRelease(array->buffer);
+  } else {
+    for (LCInteger i=0; i<array->length; i++) {
+      objectRelease(array->objects[i]);
+    }
   }
-  lcFree(objectData(object));
+  lcFree(array);
 }
 
 void arrayWalkChildren(LCObjectRef object, void *cookie, childCallback cb) {
   cb(cookie, "objects", LCArrayObjects(object), LCArrayLength(object), false);
 }
 
+// elements of a buffer shared with other arrays are held once for all of them
+void arrayWalkReferences(LCObjectRef object, void *cookie, childCallback cb) {
+  arrayDataRef data = objectData(object);
+  if (data->buffer && arrayBufferRetainCount(data->buffer) > 1) {
+    return;
+  }
+  cb(cookie, "objects", data->objects, data->length, false);
+}
+
 void arrayStoreChildren(LCObjectRef object, char *key, LCObjectRef objects[], size_t length) {
   if (strcmp(key, "objects")==0) {
     arraySetObjects(objectData(object), objects, length);
@@ -207,12 +427,7 @@ void arrayStoreChildren(LCObjectRef object, char *key, LCObjectRef objects[], si
 
 LCMutableArrayRef LCMutableArrayCreate(LCObjectRef objects[], size_t length) {
   arrayDataRef newArray = arrayInitData();
-  newArray->objects = NULL;
-  if(length > 0) {
-    arraySetObjects(newArray, objects, length);
-  } else {
-    resizeBuffer(newArray, 10);
-  }
+  arraySetObjects(newArray, objects, length);
   return objectCreate(LCTypeMutableArray, newArray);
 };
 
@@ -233,48 +448,110 @@ inline LCMutableArrayRef LCMutableArrayCreateSubArray(LCMutableArrayRef array, L
 }
 
 LCMutableArrayRef LCMutableArrayCreateFromArray(LCArrayRef array) {
-  return LCMutableArrayCreate(LCArrayObjects(array), LCArrayLength(array));
+  return objectCreate(LCTypeMutableArray, arrayDataCreateSharing(objectData(array)));
 }
 
 LCArrayRef LCMutableArrayCreateArray(LCMutableArrayRef array) {
-  return LCArrayCreate(LCMutableArrayObjects(array), LCMutableArrayLength(array));
+  return objectCreate(LCTypeArray, arrayDataCreateSharing(objectData(array)));
 }
 
 LCMutableArrayRef LCMutableArrayCopy(LCMutableArrayRef array) {
-  return LCMutableArrayCreate(LCMutableArrayObjects(array), LCMutableArrayLength(array));
+  return objectCreate(LCTypeMutableArray, arrayDataCreateSharing(objectData(array)));
 }
 
 void LCMutableArrayAddObject(LCMutableArrayRef array, LCObjectRef object) {
   arrayDataRef arrayData = objectData(array);
-  size_t arrayLength = LCMutableArrayLength(array);
-  if(arrayLength+1 > arrayData->bufferLength) {
-    resizeBuffer(arrayData, arrayData->bufferLength*2);
+  size_t arrayLength = arrayData->length;
+  size_t bufferLength = arrayData->bufferLength;
+  if (arrayLength+1 > bufferLength) {
+    bufferLength = bufferLength*2 > arrayLength+1 ? bufferLength*2 : arrayLength+1;
+  }
+  if (!resizeBuffer(arrayData, bufferLength)) {
+    return;
   }
   objectRetain(object);
-  LCMutableArrayObjects(array)[arrayLength] = object;
-  arrayData->length = arrayLength + 1;
+  arrayData->objects[arrayLength] = object;
+  arraySetLength(arrayData, arrayLength + 1);
 }
 
 void LCMutableArrayAddObjects(LCMutableArrayRef array, LCObjectRef objects[], size_t length) {
+  arrayDataRef arrayData = objectData(array);
+  LCMutableArrayInsertObjects(array, arrayData->length, objects, length);
+}
+
+void LCMutableArrayInsertObjects(LCMutableArrayRef array, LCInteger index, LCObjectRef objects[], size_t length) {
+  arrayDataRef arrayData = objectData(array);
+  size_t arrayLength = arrayData->length;
+  if (length == 0) {
+    return;
+  }
+  if (index > arrayLength) {
+    index = arrayLength;
+  }
+  size_t bufferLength = arrayData->bufferLength;
+  if (arrayLength+length > bufferLength) {
+    bufferLength = bufferLength*2 > arrayLength+length ? bufferLength*2 : arrayLength+length;
+  }
+  if (!resizeBuffer(arrayData, bufferLength)) {
+    return;
+  }
   for (LCInteger i=0; i<length; i++) {
-    LCMutableArrayAddObject(array, objects[i]);
+    objectRetain(objects[i]);
   }
+  LCObjectRef* arrayObjects = arrayData->objects;
+  memmove(&(arrayObjects[index+length]), &(arrayObjects[index]), (arrayLength-index)*sizeof(LCObjectRef));
+  memcpy(&(arrayObjects[index]), objects, length*sizeof(LCObjectRef));
+  arraySetLength(arrayData, arrayLength + length);
 }
 
 void LCMutableArrayRemoveIndex(LCMutableArrayRef array, LCInteger index) {
-  LCObjectRef* arrayObjects = LCMutableArrayObjects(array);
-  size_t arrayLength = LCMutableArrayLength(array);
   arrayDataRef arrayData = objectData(array);
+  size_t arrayLength = arrayData->length;
+  if (!resizeBuffer(arrayData, arrayLength)) {
+    return;
+  }
+  LCObjectRef* arrayObjects = arrayData->objects;
   objectRelease(arrayObjects[index]);
   if (index < (arrayLength-1)) {
     size_t objectsToCopy = arrayLength - (index+1);
     memmove(&(arrayObjects[index]), &(arrayObjects[index+1]), objectsToCopy*sizeof(LCObjectRef));
   }
-  arrayData->length = arrayLength-1;
+  arraySetLength(arrayData, arrayLength-1);
+}
+
+// indices may be unsorted and contain duplicates, out of range indices are ignored
+void LCMutableArrayRemoveIndices(LCMutableArrayRef array, LCInteger indices[], size_t length) {
+  arrayDataRef arrayData = objectData(array);
+  size_t arrayLength = arrayData->length;
+  if (length == 0 || !resizeBuffer(arrayData, arrayLength)) {
+    return;
+  }
+  bool *remove = calloc(arrayLength + 1, sizeof(bool));
+  if (!remove) {
+    perror("LCMutableArrayRemoveIndices");
+    return;
+  }
+  for (LCInteger i=0; i<length; i++) {
+    if (indices[i] >= 0 && indices[i] < arrayLength) {
+      remove[indices[i]] = true;
+    }
+  }
+  LCObjectRef* arrayObjects = arrayData->objects;
+  size_t kept = 0;
+  for (size_t i=0; i<arrayLength; i++) {
+    if (remove[i]) {
+      objectRelease(arrayObjects[i]);
+    } else {
+      arrayObjects[kept] = arrayObjects[i];
+      kept++;
+    }
+  }
+  arraySetLength(arrayData, kept);
+  lcFree(remove);
 }
 
 void LCMutableArrayRemoveObject(LCMutableArrayRef array, LCObjectRef object) {
-  for (LCInteger i=0; i<LCMutableArrayLength(object); i++) {
+  for (LCInteger i=0; i<LCMutableArrayLength(array); i++) {
     if(LCMutableArrayObjectAtIndex(array, i) == object) {
       return LCMutableArrayRemoveIndex(array, i);
     }
@@ -282,30 +559,75 @@ void LCMutableArrayRemoveObject(LCMutableArrayRef array, LCObjectRef object) {
 }
 
 void LCMutableArraySort(LCMutableArrayRef array) {
-  objectsSort(LCMutableArrayObjects(array), LCMutableArrayLength(array));
+  arrayDataRef arrayData = objectData(array);
+  if (resizeBuffer(arrayData, arrayData->length)) {
+    objectsSort(arrayData->objects, arrayData->length);
+  }
 }
 
-LCMutableArrayRef LCArrayCreateMutableArrayWithMap(LCArrayRef array, void* info, LCCreateEachCb each) {
-  size_t arrayLength = LCArrayLength(array);
-  LCArrayRef* arrayObjects = LCArrayObjects(array);
-  LCArrayRef newObjects[arrayLength];
-  for (LCInteger i=0; i<arrayLength; i++) {
-    newObjects[i] = each(i, info, arrayObjects[i]);
-  }
-  LCArrayRef newArray = LCMutableArrayCreate(newObjects, arrayLength);
-  for (LCInteger i=0; i<arrayLength; i++) {
-    objectRelease(newObjects[i]);
+void LCMutableArraySortStable(LCMutableArrayRef array) {
+  arrayDataRef arrayData = objectData(array);
+  if (resizeBuffer(arrayData, arrayData->length)) {
+    objectsSortStable(arrayData->objects, arrayData->length);
   }
-  return newArray;
 }
 
+LCMutableArrayRef LCArrayCreateMutableArrayWithMap(LCArrayRef array, void* info, LCCreateEachCb each) {
+  return arrayCreateWithMap(LCTypeMutableArray, array, info, each, false);
+}
+
+/*
+ makes the array the only owner of storage for at least length objects, this is where copy on write
+ happens: inline slots move to a new heap buffer, a buffer owned alone grows in place and shared or
+ static storage is copied, retaining the objects for the copy; buffers never shrink
+*/
 bool resizeBuffer(arrayDataRef array, size_t length) {
-  void* buffer = realloc(array->objects, sizeof(void*) * length);
-  if(buffer) {
-    array->objects = buffer;
+  bool ownsStorage = arrayOwnsStorage(array);
+  if (ownsStorage && length <= array->bufferLength) {
+    return true;
+  }
+  if (length < array->length) {
+    length = array->length;
+  }
+  if (ownsStorage && array->buffer) {
+    struct arrayBuffer *grown = realloc(array->buffer, sizeof(struct arrayBuffer) + sizeof(LCObjectRef) * length);
+    if (!grown) {
+      perror("resizeBuffer");
+      return false;
+    }
+    grown->capacity = length;
+    array->buffer = grown;
+    array->objects = grown->objects;
     array->bufferLength = length;
     return true;
+  }
+  struct arrayBuffer *oldBuffer = array->buffer;
+  if (length <= LC_ARRAY_INLINE_LENGTH) {
+    memcpy(array->inlineObjects, array->objects, sizeof(LCObjectRef) * array->length);
+    array->objects = array->inlineObjects;
+    array->bufferLength = LC_ARRAY_INLINE_LENGTH;
+    array->buffer = NULL;
   } else {
-    return false;
+    struct arrayBuffer *buffer = malloc(sizeof(struct arrayBuffer) + sizeof(LCObjectRef) * length);
+    if (!buffer) {
+      perror("resizeBuffer");
+      return false;
+    }
+    buffer->rCount = 1;
+    buffer->length = array->length;
+    buffer->capacity = length;
+    memcpy(buffer->objects, array->objects, sizeof(LCObjectRef) * array->length);
+    array->objects = buffer->objects;
+    array->bufferLength = length;
+    array->buffer = buffer;
+  }
+  if (!ownsStorage) {
+    for (LCInteger i=0; i<array->length; i++) {
+      objectRetain(array->objects[i]);
+    }
+    if (oldBuffer) {
+      arrayBufferRelease(oldBuffer);
+    }
   }
+  return true;
 }
@@ -5,12 +5,42 @@
 
 #include "LCCore.h"
 
+#define LC_ARRAY_INLINE_LENGTH 4
+
+struct arrayBuffer;
+
+/*
+ - objects points to inlineObjects until the array needs more than LC_ARRAY_INLINE_LENGTH slots,
+   then into buffer, a reference counted heap buffer that copies of the array share until one
+   of them is mutated; static arrays point to their static objects
+ - inline storage holds a reference to each element for the array, a shared buffer holds one
+   reference to each element for all arrays using it
+*/
+struct arrayData {
+  size_t length;
+  size_t bufferLength;
+  LCObjectRef* objects;
+  struct arrayBuffer *buffer;
+  LCObjectRef inlineObjects[LC_ARRAY_INLINE_LENGTH];
+};
+
 typedef LCObjectRef LCArrayRef;
+extern struct LCType typeArray;
 extern LCTypeRef LCTypeArray;
 
 typedef LCObjectRef LCMutableArrayRef;
 extern LCTypeRef LCTypeMutableArray;
 
+// defines an immortal LCArray of static objects, elements are given with LCStaticRef
+#define LCStaticArray(name, ...) \
+  static LCObjectRef name##Objects[] = {__VA_ARGS__}; \
+  static struct arrayData name##Data = { \
+    .length = sizeof(name##Objects) / sizeof(LCObjectRef), \
+    .bufferLength = sizeof(name##Objects) / sizeof(LCObjectRef), \
+    .objects = name##Objects \
+  }; \
+  LCStaticObject(name, typeArray, name##Data)
+
 LCArrayRef LCArrayCreate(LCObjectRef objects[], size_t length);
 LCArrayRef LCArrayCreateFromHash(LCContextRef context, char hash[HASH_LENGTH]);
 LCArrayRef LCArrayCreateAppendingObject(LCArrayRef array, LCObjectRef object);
@@ -21,6 +51,10 @@ LCObjectRef LCArrayObjectAtIndex(LCArrayRef array, LCInteger index);
 size_t LCArrayLength(LCArrayRef array);
 LCArrayRef LCArrayCreateSubArray(LCArrayRef array, LCInteger start, size_t length);
 LCArrayRef LCArrayCreateArrayWithMap(LCArrayRef array, void* info, LCCreateEachCb each);
+LCArrayRef LCArrayCreateArrayWithParallelMap(LCArrayRef array, void* info, LCCreateEachCb each);
+LCArrayRef LCArrayCreateArrayWithParallelFilter(LCArrayRef array, void* info, LCFilterEachCb each);
+void LCArrayParallelReduce(LCArrayRef array, void* info, void *accumulator, size_t accumulatorSize,
+                           LCReduceCb each, LCCombineCb combine);
 
 LCMutableArrayRef LCMutableArrayCreate(LCObjectRef objects[], size_t length);
 LCObjectRef* LCMutableArrayObjects(LCMutableArrayRef array);
@@ -33,8 +67,11 @@ LCArrayRef LCMutableArrayCreateArray(LCMutableArrayRef array);
 LCMutableArrayRef LCMutableArrayCopy(LCMutableArrayRef array);
 void LCMutableArrayAddObject(LCMutableArrayRef array, LCObjectRef object);
 void LCMutableArrayAddObjects(LCMutableArrayRef array, LCObjectRef objects[], size_t length);
+void LCMutableArrayInsertObjects(LCMutableArrayRef array, LCInteger index, LCObjectRef objects[], size_t length);
 void LCMutableArrayRemoveIndex(LCMutableArrayRef array, LCInteger index);
+void LCMutableArrayRemoveIndices(LCMutableArrayRef array, LCInteger indices[], size_t length);
 void LCMutableArrayRemoveObject(LCMutableArrayRef array, LCObjectRef object);
 void LCMutableArraySort(LCMutableArrayRef array);
+void LCMutableArraySortStable(LCMutableArrayRef array);
 LCMutableArrayRef LCArrayCreateMutableArrayWithMap(LCArrayRef array, void* info, LCCreateEachCb each);
 #endif
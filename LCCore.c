@@ -6,36 +6,69 @@
 #include "JsonSerialization.h"
 
 #define FILE_BUFFER_LENGTH 1024
+#define SORT_PARALLEL_MIN_CHUNK 4096
+#define SORT_INSERTION_LENGTH 16
+#define SORT_KEY_LEVELS 8
+#define OBJECT_DEFAULT_DATA_SIZE 64
+#define REGION_CHUNK_LENGTH 64
+#define META_RECORD_SUFFIX ".meta"
+#define META_RECORD_KEY_LENGTH (HASH_LENGTH + sizeof(META_RECORD_SUFFIX) - 1)
 
 void objectWalkChildren(LCObjectRef object, void *cookie, childCallback callback);
 static void objectStoreWithCompositeParam(LCObjectRef object, bool composite, LCContextRef context);
 
-struct LCObject {
-  LCTypeRef type;
-  LCInteger rCount;
-  LCContextRef context;
-  char *hash;
-  void *data;
-};
-
 struct LCStore {
   void *cookie;
   writeData writefn;
   deleteData deletefn;
   readData readfn;
+  readManyData readManyfn;
+};
+
+/*
+ - entries of resident objects that are not pinned form a ring of cacheLength entries from
+   cacheHead, the most recently loaded, back to cacheTail; objectData only sets referenced, eviction
+   moves referenced entries back to the head instead of evicting them
+ - pinned entries are kept out of the ring until they are unpinned
+ - an entry lives as long as its object, evicted objects keep it with resident false
+*/
+struct objectCacheEntry {
+  LCObjectRef object;
+  LCContextRef context;
+  size_t size;
+  LCInteger pins;
+  bool resident;
+  bool referenced;
+  struct objectCacheEntry *previous;
+  struct objectCacheEntry *next;
 };
 
 struct LCContext {
   LCStoreRef store;
+  LCCacheStats cacheStats;
+  struct objectCacheEntry *cacheHead;
+  struct objectCacheEntry *cacheTail;
+  size_t cacheLength;
+  pthread_mutex_t identityLock;
+  LCObjectRef *identitySlots;
+  size_t identityCapacity;
+  size_t identityLength;
+  bool sharesIdentities;
   size_t translationFunsLength;
   stringToType translationFuns[];
 };
 
 static char* _objectHash(LCObjectRef object) {
+  if (objectIsTaggedInteger(object) || (object->hash && object->hash[0] == '\0')) {
+    return NULL;
+  }
   return object->hash;
 }
 
 static void _objectSetHash(LCObjectRef object, char hash[HASH_LENGTH]) {
+  if (objectIsTaggedInteger(object)) {
+    return;
+  }
   if (!hash) {
     if (object->hash) {
       lcFree(object->hash);
@@ -48,36 +81,365 @@ static void _objectSetHash(LCObjectRef object, char hash[HASH_LENGTH]) {
   strcpy(object->hash, hash);
 }
 
+/*
+ - regions nest per thread, objects created while a region is active get their header from the
+   region's chunks instead of the heap, objectAutorelease defers one release to regionEnd
+ - live counts the objects of a chunk that were not deallocated yet plus one while its region is
+   active, whoever drops it to zero frees the chunk, so objects that escape their region keep
+   their chunk alive and may be released from any thread
+*/
+struct regionChunk {
+  LCInteger live;
+  size_t used;
+  struct regionChunk *next;
+  struct LCObject objects[REGION_CHUNK_LENGTH];
+};
+
+struct region {
+  struct region *previous;
+  struct regionChunk *chunks;
+  LCObjectRef *autoreleased;
+  size_t autoreleasedLength;
+  size_t autoreleasedCapacity;
+};
+
+static __thread struct region *currentRegion = NULL;
+
+/*
+ objects released to zero in the deferred modes wait in releaseQueue, releaseActive counts objects
+ popped from it that are still being torn down; releaseIdle is signalled when both reach zero
+*/
+static LCReleaseMode releaseMode = LCReleaseImmediate;
+static pthread_mutex_t releaseLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t releaseQueued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t releaseIdle = PTHREAD_COND_INITIALIZER;
+static LCObjectRef *releaseQueue = NULL;
+static size_t releaseQueueLength = 0;
+static size_t releaseQueueCapacity = 0;
+static size_t releaseActive = 0;
+static bool releaseThreadStarted = false;
+
+/*
+ - the cycle collector is a synchronous trial deletion collector after Bacon and Rajan: objects
+   with children whose count drops to a non zero value are buffered as possible roots of garbage
+   cycles, cycleCollect subtracts the references between objects reachable from them and frees
+   the ones that end up unreferenced from outside
+ - roots are buffered per thread, objects that die while buffered keep their header until the
+   collector drops them from the buffer
+*/
+enum {
+  cycleBlack,
+  cycleGray,
+  cycleWhite,
+  cyclePurple,
+  cycleGarbage,
+  cycleDead
+};
+
+struct objectStack {
+  LCObjectRef *objects;
+  size_t length;
+  size_t capacity;
+};
+
+static bool cycleCollectionEnabled = false;
+static __thread struct objectStack cycleRoots = {NULL, 0, 0};
+
+// known has bit 1 << key set for every key in values
+struct objectMeta {
+  LCInteger known;
+  uint64_t values[LCMetaKeysCount];
+};
+
+/*
+ the state of the opt-in features is kept out of the header, an object gets its extension the first
+ time it joins a cache budget, is pinned, gets reference meta or is traced by the cycle collector and
+ keeps it until its header is freed; objects without one are black and not buffered
+*/
+struct objectExtension {
+  struct objectCacheEntry *cacheEntry;
+  struct objectMeta referenceMeta;
+  unsigned char cycleColor;
+  bool cycleBuffered;
+};
+
+static struct objectExtension* objectExtensionCreate(LCObjectRef object) {
+  if (!object->extension) {
+    struct objectExtension *extension = malloc(sizeof(struct objectExtension));
+    if (!extension) {
+      perror("objectExtensionCreate");
+      return NULL;
+    }
+    extension->cacheEntry = NULL;
+    extension->referenceMeta.known = 0;
+    extension->cycleColor = cycleBlack;
+    extension->cycleBuffered = false;
+    object->extension = extension;
+  }
+  return object->extension;
+}
+
+static struct objectCacheEntry* objectCacheEntryOf(LCObjectRef object) {
+  return object->extension ? object->extension->cacheEntry : NULL;
+}
+
+static unsigned char objectCycleColor(LCObjectRef object) {
+  return object->extension ? object->extension->cycleColor : cycleBlack;
+}
+
+static bool objectCycleBuffered(LCObjectRef object) {
+  return object->extension && object->extension->cycleBuffered;
+}
+
+void regionBegin() {
+  struct region *region = malloc(sizeof(struct region));
+  if (!region) {
+    perror("regionBegin");
+    return;
+  }
+  region->previous = currentRegion;
+  region->chunks = NULL;
+  region->autoreleased = NULL;
+  region->autoreleasedLength = 0;
+  region->autoreleasedCapacity = 0;
+  currentRegion = region;
+}
+
+static void regionChunkRelease(struct regionChunk *chunk) {
+  if (__atomic_sub_fetch(&chunk->live, 1, __ATOMIC_ACQ_REL) == 0) {
+    lcFree(chunk);
+  }
+}
+
+static LCObjectRef regionAllocate(struct region *region) {
+  struct regionChunk *chunk = region->chunks;
+  if (!chunk || chunk->used == REGION_CHUNK_LENGTH) {
+    chunk = malloc(sizeof(struct regionChunk));
+    if (!chunk) {
+      return NULL;
+    }
+    chunk->live = 1;
+    chunk->used = 0;
+    chunk->next = region->chunks;
+    region->chunks = chunk;
+  }
+  __atomic_add_fetch(&chunk->live, 1, __ATOMIC_RELAXED);
+  LCObjectRef object = &chunk->objects[chunk->used];
+  chunk->used++;
+  object->chunk = chunk;
+  return object;
+}
+
+// objects created by deallocs while the region ends go to the enclosing region
+void regionEnd() {
+  struct region *region = currentRegion;
+  if (!region) {
+    return;
+  }
+  currentRegion = region->previous;
+  for (size_t i=0; i<region->autoreleasedLength; i++) {
+    objectRelease(region->autoreleased[i]);
+  }
+  struct regionChunk *chunk = region->chunks;
+  while (chunk) {
+    struct regionChunk *next = chunk->next;
+    regionChunkRelease(chunk);
+    chunk = next;
+  }
+  lcFree(region->autoreleased);
+  lcFree(region);
+}
+
+LCObjectRef objectAutorelease(LCObjectRef object) {
+  struct region *region = currentRegion;
+  if (!object || objectIsTaggedInteger(object) || object->rCount == LC_IMMORTAL_RETAIN_COUNT) {
+    return object;
+  }
+  if (!region) {
+    perror(ErrorNoRegion);
+    return object;
+  }
+  if (region->autoreleasedLength == region->autoreleasedCapacity) {
+    size_t capacity = region->autoreleasedCapacity ? region->autoreleasedCapacity * 2 : 16;
+    LCObjectRef *autoreleased = realloc(region->autoreleased, sizeof(LCObjectRef) * capacity);
+    if (!autoreleased) {
+      perror("objectAutorelease");
+      return object;
+    }
+    region->autoreleased = autoreleased;
+    region->autoreleasedCapacity = capacity;
+  }
+  region->autoreleased[region->autoreleasedLength] = object;
+  region->autoreleasedLength++;
+  return object;
+}
+
 LCObjectRef objectCreate(LCTypeRef type, void* data) {
-  LCObjectRef object = malloc(sizeof(struct LCObject));
+  LCObjectRef object = NULL;
+  if (currentRegion) {
+    object = regionAllocate(currentRegion);
+  }
+  if (!object) {
+    object = malloc(sizeof(struct LCObject));
+    if (object) {
+      object->chunk = NULL;
+    }
+  }
   if (object) {
     object->rCount = 1;
     object->type = type;
     object->data = data;
     object->context = NULL;
     object->hash = NULL;
+    object->extension = NULL;
   }
   return object;
 }
 
 char *LCUnnamedObject = "LCUnnamedObject";
 
+/*
+ the identity map of a context holds a weak reference to every immutable object created from it by
+ digest, open addressing with linear probing over identityCapacity slots, a power of two;
+ objects remove themselves when they are deallocated or move to another context
+*/
+static size_t contextIdentitySlot(LCContextRef context, LCTypeRef type, char hash[HASH_LENGTH]) {
+  size_t slot = (hashBytes((LCByte*)hash, strlen(hash)) ^ (size_t)type) & (context->identityCapacity - 1);
+  while (context->identitySlots[slot]) {
+    LCObjectRef object = context->identitySlots[slot];
+    if (object->type == type && strcmp(object->hash, hash) == 0) {
+      break;
+    }
+    slot = (slot + 1) & (context->identityCapacity - 1);
+  }
+  return slot;
+}
+
+static bool contextIdentityGrow(LCContextRef context) {
+  size_t oldCapacity = context->identityCapacity;
+  LCObjectRef *oldSlots = context->identitySlots;
+  size_t newCapacity = oldCapacity ? oldCapacity * 2 : 64;
+  LCObjectRef *newSlots = calloc(newCapacity, sizeof(LCObjectRef));
+  if (!newSlots) {
+    perror("contextIdentityGrow");
+    return false;
+  }
+  context->identityCapacity = newCapacity;
+  context->identitySlots = newSlots;
+  for (size_t i=0; i<oldCapacity; i++) {
+    if (oldSlots[i]) {
+      newSlots[contextIdentitySlot(context, oldSlots[i]->type, oldSlots[i]->hash)] = oldSlots[i];
+    }
+  }
+  lcFree(oldSlots);
+  return true;
+}
+
+/*
+ retains the object unless its count already dropped to zero, for lookups in tables that hold
+ objects weakly, a deferred release can leave a dead object in them until it is torn down
+*/
+bool objectRetainIfLive(LCObjectRef object) {
+  if (!object || objectIsTaggedInteger(object) || object->rCount == LC_IMMORTAL_RETAIN_COUNT) {
+    return true;
+  }
+  LCInteger count = __atomic_load_n(&object->rCount, __ATOMIC_RELAXED);
+  while (count > 0 && !__atomic_compare_exchange_n(&object->rCount, &count, count + 1, true,
+                                                    __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+  }
+  return count > 0;
+}
+
+static void contextIdentityRemove(LCObjectRef object) {
+  LCContextRef context = object->context;
+  if (!context || !object->hash || !object->type->immutable) {
+    return;
+  }
+  pthread_mutex_lock(&context->identityLock);
+  if (context->identityLength > 0) {
+    size_t slot = contextIdentitySlot(context, object->type, object->hash);
+    if (context->identitySlots[slot] == object) {
+      context->identitySlots[slot] = NULL;
+      context->identityLength--;
+      size_t next = (slot + 1) & (context->identityCapacity - 1);
+      while (context->identitySlots[next]) {
+        LCObjectRef moved = context->identitySlots[next];
+        context->identitySlots[next] = NULL;
+        context->identitySlots[contextIdentitySlot(context, moved->type, moved->hash)] = moved;
+        next = (next + 1) & (context->identityCapacity - 1);
+      }
+    }
+  }
+  pthread_mutex_unlock(&context->identityLock);
+}
+
+// immutable objects with a digest are shared in contexts that share identities, see contextSetSharesIdentities
 LCObjectRef objectCreateFromContext(LCContextRef context, LCTypeRef type, char hash[HASH_LENGTH]) {
+  bool shared = context && context->sharesIdentities && hash && type && type->immutable;
+  if (shared) {
+    pthread_mutex_lock(&context->identityLock);
+    if (context->identityLength * 2 >= context->identityCapacity && !contextIdentityGrow(context)) {
+      shared = false;
+      pthread_mutex_unlock(&context->identityLock);
+    }
+  }
+  LCObjectRef *slot = NULL;
+  if (shared) {
+    slot = &context->identitySlots[contextIdentitySlot(context, type, hash)];
+    if (*slot && objectRetainIfLive(*slot)) {
+      LCObjectRef object = *slot;
+      pthread_mutex_unlock(&context->identityLock);
+      return object;
+    }
+  }
   LCObjectRef object = objectCreate(type, NULL);
   object->context = context;
   if (hash) {
     _objectSetHash(object, hash);
   }
+  if (shared) {
+    if (!*slot) {
+      context->identityLength++;
+    }
+    *slot = object;
+    pthread_mutex_unlock(&context->identityLock);
+  }
   return object;
 }
 
 LCObjectRef objectCreateFromFile(LCContextRef context, LCTypeRef type, FILE *fd) {
-  return objectCreateFromJsonFile(fd, context);
+  LCObjectRef object = objectCreateFromContext(context, type, NULL);
+  objectDeserialize(object, fd);
+  return object;
+}
+
+LCObjectRef objectCreateTaggedInteger(int64_t value) {
+  return (LCObjectRef)(((uintptr_t)value << 1) | 1);
+}
+
+bool objectIsTaggedInteger(LCObjectRef object) {
+  return ((uintptr_t)object & 1) == 1;
+}
+
+int64_t objectTaggedIntegerValue(LCObjectRef object) {
+  return (int64_t)(intptr_t)object >> 1;
+}
+
+bool objectIsImmortal(LCObjectRef object) {
+  return !objectIsTaggedInteger(object) && object->rCount == LC_IMMORTAL_RETAIN_COUNT;
 }
 
 void* objectData(LCObjectRef object) {
+  if (objectIsTaggedInteger(object)) {
+    return NULL;
+  }
   if (!object->data) {
     objectCache(object);
+  } else if (object->extension) {
+    struct objectCacheEntry *entry = object->extension->cacheEntry;
+    if (entry && !__atomic_load_n(&entry->referenced, __ATOMIC_RELAXED)) {
+      __atomic_store_n(&entry->referenced, true, __ATOMIC_RELAXED);
+    }
   }
   return object->data;
 }
@@ -86,6 +448,9 @@ LCTypeRef objectType(LCObjectRef object) {
   if (!object) {
     return NULL;
   }
+  if (objectIsTaggedInteger(object)) {
+    return LCTypeNumber;
+  }
   return object->type;
 }
 
@@ -99,37 +464,644 @@ bool objectsImmutable(LCObjectRef objects[], size_t length) {
       return false;
     }
   }
-  return true;
+  return true;
+}
+
+/*
+ adds delta to a retain count, also counts kept outside object headers such as buffers shared by
+ several objects; the update is atomic whenever the release mode makes objectRelease atomic
+*/
+LCInteger retainCountAdd(LCInteger *count, LCInteger delta) {
+  if (__atomic_load_n(&releaseMode, __ATOMIC_ACQUIRE) == LCReleaseBackground) {
+    return __atomic_add_fetch(count, delta, __ATOMIC_ACQ_REL);
+  }
+  *count = *count + delta;
+  return *count;
+}
+
+LCObjectRef objectRetain(LCObjectRef object) {
+  if (object && !objectIsTaggedInteger(object) && object->rCount != LC_IMMORTAL_RETAIN_COUNT) {
+    retainCountAdd(&object->rCount, 1);
+  }
+  return object;
+}
+
+static void objectCacheUnlink(struct objectCacheEntry *entry) {
+  LCContextRef context = entry->context;
+  if (entry->previous) {
+    entry->previous->next = entry->next;
+  } else {
+    context->cacheHead = entry->next;
+  }
+  if (entry->next) {
+    entry->next->previous = entry->previous;
+  } else {
+    context->cacheTail = entry->previous;
+  }
+  entry->previous = NULL;
+  entry->next = NULL;
+  context->cacheLength--;
+}
+
+static void objectCacheLink(struct objectCacheEntry *entry) {
+  LCContextRef context = entry->context;
+  entry->previous = NULL;
+  entry->next = context->cacheHead;
+  if (context->cacheHead) {
+    context->cacheHead->previous = entry;
+  } else {
+    context->cacheTail = entry;
+  }
+  context->cacheHead = entry;
+  context->cacheLength++;
+}
+
+static struct objectCacheEntry* objectCacheEntryCreate(LCObjectRef object) {
+  struct objectExtension *extension = objectExtensionCreate(object);
+  if (!extension) {
+    return NULL;
+  }
+  if (!extension->cacheEntry) {
+    struct objectCacheEntry *entry = malloc(sizeof(struct objectCacheEntry));
+    if (!entry) {
+      perror("objectCacheEntryCreate");
+      return NULL;
+    }
+    entry->object = object;
+    entry->context = NULL;
+    entry->size = 0;
+    entry->pins = 0;
+    entry->resident = false;
+    entry->referenced = false;
+    entry->previous = NULL;
+    entry->next = NULL;
+    extension->cacheEntry = entry;
+  }
+  return extension->cacheEntry;
+}
+
+static void objectCacheRemove(LCObjectRef object) {
+  struct objectCacheEntry *entry = objectCacheEntryOf(object);
+  if (entry && entry->resident) {
+    if (entry->pins == 0) {
+      objectCacheUnlink(entry);
+    }
+    entry->context->cacheStats.used = entry->context->cacheStats.used - entry->size;
+    entry->context->cacheStats.resident--;
+    entry->resident = false;
+  }
+}
+
+static void objectDataDealloc(LCObjectRef object);
+
+/*
+ visits every entry at most once, so objects used since the last eviction survive it even if that
+ leaves the cache over budget, and the last entry is never evicted
+*/
+static void contextCacheEvict(LCContextRef context) {
+  for (size_t steps=context->cacheLength; steps > 0 && context->cacheStats.budget > 0 &&
+       context->cacheStats.used > context->cacheStats.budget && context->cacheTail != context->cacheHead; steps--) {
+    struct objectCacheEntry *entry = context->cacheTail;
+    if (entry->referenced) {
+      entry->referenced = false;
+      objectCacheUnlink(entry);
+      objectCacheLink(entry);
+    } else {
+      objectDataDealloc(entry->object);
+      context->cacheStats.evictions++;
+    }
+  }
+}
+
+/*
+ only immutable objects without children are evicted: their data can always be read again from the
+ store and dropping it never releases objects that callers may still be using
+*/
+static void objectCacheLoaded(LCObjectRef object) {
+  LCContextRef context = object->context;
+  LCTypeRef type = objectType(object);
+  if (!context || context->cacheStats.budget == 0 || !object->data || !type->immutable || type->walkChildren) {
+    return;
+  }
+  bool evicted = objectCacheEntryOf(object) && objectCacheEntryOf(object)->context;
+  struct objectCacheEntry *entry = objectCacheEntryCreate(object);
+  if (!entry || entry->resident) {
+    return;
+  }
+  entry->context = context;
+  entry->size = type->dataSize ? type->dataSize(object) : OBJECT_DEFAULT_DATA_SIZE;
+  entry->resident = true;
+  entry->referenced = true;
+  if (entry->pins == 0) {
+    objectCacheLink(entry);
+  }
+  context->cacheStats.used = context->cacheStats.used + entry->size;
+  context->cacheStats.resident++;
+  context->cacheStats.loads++;
+  if (evicted) {
+    context->cacheStats.refaults++;
+  }
+  contextCacheEvict(context);
+}
+
+static char* objectMetaKeyNames[LCMetaKeysCount] = {"length", "size", "sortKey"};
+
+char* objectMetaKeyName(LCMetaKey key) {
+  return objectMetaKeyNames[key];
+}
+
+/*
+ answers key for immutable objects that are not loaded and whose reference recorded it, a mutable
+ object can change after its reference was written so its stubs never answer
+*/
+bool objectStubMeta(LCObjectRef object, LCMetaKey key, uint64_t *value) {
+  if (objectIsTaggedInteger(object) || object->data || !object->type->immutable || !object->extension ||
+      !(object->extension->referenceMeta.known & (1 << key))) {
+    return false;
+  }
+  *value = object->extension->referenceMeta.values[key];
+  return true;
+}
+
+// ignored for mutable objects and objects that are loaded already, shared stubs keep what their first reference recorded
+void objectSetStubMeta(LCObjectRef object, LCMetaKey key, uint64_t value) {
+  if (objectIsTaggedInteger(object) || object->data || !object->type->immutable) {
+    return;
+  }
+  struct objectExtension *extension = objectExtensionCreate(object);
+  if (extension && !(extension->referenceMeta.known & (1 << key))) {
+    extension->referenceMeta.known = extension->referenceMeta.known | (1 << key);
+    extension->referenceMeta.values[key] = value;
+  }
+}
+
+/*
+ answers key from a stub's meta or from the type of a loaded object, never loads the object;
+ false if neither knows the value
+*/
+bool objectReferenceMeta(LCObjectRef object, LCMetaKey key, uint64_t *value) {
+  if (!object || objectIsTaggedInteger(object)) {
+    return false;
+  }
+  if (!object->data) {
+    return objectStubMeta(object, key, value);
+  }
+  LCTypeRef type = objectType(object);
+  if (key == LCMetaLength && type->length) {
+    *value = type->length(object);
+    return true;
+  }
+  if (key == LCMetaSize && type->dataSize) {
+    *value = type->dataSize(object);
+    return true;
+  }
+  if (key == LCMetaSortKey && type->sortKey) {
+    *value = type->sortKey(object, 0);
+    return true;
+  }
+  return false;
+}
+
+// keeps the object's data loaded until the matching objectUnpin, pins nest
+void objectPin(LCObjectRef object) {
+  if (!object || objectIsTaggedInteger(object) || objectIsImmortal(object)) {
+    return;
+  }
+  objectData(object);
+  struct objectCacheEntry *entry = objectCacheEntryCreate(object);
+  if (entry) {
+    if (entry->resident && entry->pins == 0) {
+      objectCacheUnlink(entry);
+    }
+    entry->pins++;
+  }
+}
+
+void objectUnpin(LCObjectRef object) {
+  if (!object || objectIsTaggedInteger(object) || !objectCacheEntryOf(object) || objectCacheEntryOf(object)->pins == 0) {
+    return;
+  }
+  struct objectCacheEntry *entry = objectCacheEntryOf(object);
+  entry->pins--;
+  if (entry->resident && entry->pins == 0) {
+    objectCacheLink(entry);
+    contextCacheEvict(entry->context);
+  }
+}
+
+static bool objectFromContext(LCObjectRef object) {
+  return object && !objectIsTaggedInteger(object) && !objectIsImmortal(object) && object->context;
+}
+
+/*
+ loads every object and pins the ones a cache budget could evict, so threads working on them
+ afterwards only ever read their data and never touch the cache ring; objects without a context
+ are left alone
+*/
+void objectsPin(LCObjectRef objects[], size_t length) {
+  for (size_t i=0; i<length; i++) {
+    if (objectFromContext(objects[i])) {
+      objectPin(objects[i]);
+    }
+  }
+}
+
+void objectsUnpin(LCObjectRef objects[], size_t length) {
+  for (size_t i=0; i<length; i++) {
+    if (objectFromContext(objects[i])) {
+      objectUnpin(objects[i]);
+    }
+  }
+}
+
+static void objectDataDealloc(LCObjectRef object) {
+  if (object->data && object->rCount != LC_IMMORTAL_RETAIN_COUNT) {
+    objectCacheRemove(object);
+    if(object->type->dealloc) {
+      object->type->dealloc(object);
+    } else {
+      lcFree(object->data);
+    }
+    object->data = NULL;
+  }
+}
+
+static void objectFreeHeader(LCObjectRef object) {
+  lcFree(object->extension);
+  object->extension = NULL;
+  if (object->chunk) {
+    regionChunkRelease(object->chunk);
+  } else {
+    lcFree(object);
+  }
+}
+
+static void objectDestroy(LCObjectRef object) {
+  weakRefsClear(object);
+  contextIdentityRemove(object);
+  objectDataDealloc(object);
+  if (object->extension) {
+    lcFree(object->extension->cacheEntry);
+    object->extension->cacheEntry = NULL;
+    object->extension->referenceMeta.known = 0;
+  }
+  if (objectCycleBuffered(object)) {
+    object->extension->cycleColor = cycleDead;
+  } else {
+    objectFreeHeader(object);
+  }
+}
+
+static bool objectStackPush(struct objectStack *stack, LCObjectRef object) {
+  if (stack->length == stack->capacity) {
+    size_t capacity = stack->capacity ? stack->capacity * 2 : 64;
+    LCObjectRef *objects = realloc(stack->objects, sizeof(LCObjectRef) * capacity);
+    if (!objects) {
+      perror("objectStackPush");
+      return false;
+    }
+    stack->objects = objects;
+    stack->capacity = capacity;
+  }
+  stack->objects[stack->length] = object;
+  stack->length++;
+  return true;
+}
+
+static bool objectTraceable(LCObjectRef object) {
+  return object && !objectIsTaggedInteger(object) && object->rCount > 0 && object->data &&
+    (object->type->walkReferences || object->type->walkChildren);
+}
+
+static void cycleRootsAdd(LCObjectRef object) {
+  if (!objectTraceable(object) || objectCycleColor(object) == cyclePurple || objectCycleColor(object) == cycleGarbage) {
+    return;
+  }
+  struct objectExtension *extension = objectExtensionCreate(object);
+  if (!extension) {
+    return;
+  }
+  extension->cycleColor = cyclePurple;
+  if (!extension->cycleBuffered && objectStackPush(&cycleRoots, object)) {
+    extension->cycleBuffered = true;
+  }
+}
+
+static bool releaseQueuePush(LCObjectRef object) {
+  pthread_mutex_lock(&releaseLock);
+  if (releaseQueueLength == releaseQueueCapacity) {
+    size_t capacity = releaseQueueCapacity ? releaseQueueCapacity * 2 : 256;
+    LCObjectRef *queue = realloc(releaseQueue, sizeof(LCObjectRef) * capacity);
+    if (!queue) {
+      pthread_mutex_unlock(&releaseLock);
+      perror("releaseQueuePush");
+      return false;
+    }
+    releaseQueue = queue;
+    releaseQueueCapacity = capacity;
+  }
+  releaseQueue[releaseQueueLength] = object;
+  releaseQueueLength++;
+  pthread_cond_signal(&releaseQueued);
+  pthread_mutex_unlock(&releaseLock);
+  return true;
+}
+
+// must be called with releaseLock held and a non empty queue
+static LCObjectRef releaseQueuePop() {
+  releaseQueueLength--;
+  releaseActive++;
+  return releaseQueue[releaseQueueLength];
+}
+
+static void releaseDone() {
+  pthread_mutex_lock(&releaseLock);
+  releaseActive--;
+  if (releaseQueueLength == 0 && releaseActive == 0) {
+    pthread_cond_broadcast(&releaseIdle);
+  }
+  pthread_mutex_unlock(&releaseLock);
+}
+
+// limit 0 drains the queue until it is empty
+size_t releaseDrain(size_t limit) {
+  size_t destroyed = 0;
+  while (limit == 0 || destroyed < limit) {
+    pthread_mutex_lock(&releaseLock);
+    if (releaseQueueLength == 0) {
+      pthread_mutex_unlock(&releaseLock);
+      break;
+    }
+    LCObjectRef object = releaseQueuePop();
+    pthread_mutex_unlock(&releaseLock);
+    objectDestroy(object);
+    releaseDone();
+    destroyed++;
+  }
+  return destroyed;
+}
+
+size_t releasePending() {
+  pthread_mutex_lock(&releaseLock);
+  size_t pending = releaseQueueLength + releaseActive;
+  pthread_mutex_unlock(&releaseLock);
+  return pending;
+}
+
+static void* releaseThread(void *cookie) {
+  pthread_mutex_lock(&releaseLock);
+  while (true) {
+    while (releaseQueueLength == 0 || releaseMode != LCReleaseBackground) {
+      pthread_cond_wait(&releaseQueued, &releaseLock);
+    }
+    LCObjectRef object = releaseQueuePop();
+    pthread_mutex_unlock(&releaseLock);
+    objectDestroy(object);
+    releaseDone();
+    pthread_mutex_lock(&releaseLock);
+  }
+  return NULL;
+}
+
+/*
+ - the mode is process wide and should be chosen before objects are shared between threads
+ - changing the mode first destroys everything still queued, waiting for the background thread
+   to finish the objects it is tearing down
+*/
+void releaseSetMode(LCReleaseMode mode) {
+  if (mode == LCReleaseBackground && !releaseThreadStarted) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, releaseThread, NULL) != 0) {
+      perror("releaseSetMode");
+      return;
+    }
+    pthread_detach(thread);
+    releaseThreadStarted = true;
+  }
+  if (mode != releaseMode) {
+    releaseDrain(0);
+    pthread_mutex_lock(&releaseLock);
+    while (releaseQueueLength > 0 || releaseActive > 0) {
+      pthread_cond_wait(&releaseIdle, &releaseLock);
+    }
+    pthread_mutex_unlock(&releaseLock);
+  }
+  pthread_mutex_lock(&releaseLock);
+  __atomic_store_n(&releaseMode, mode, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&releaseQueued);
+  pthread_mutex_unlock(&releaseLock);
+}
+
+LCObjectRef objectRelease(LCObjectRef object) {
+  if (object && !objectIsTaggedInteger(object) && object->rCount != LC_IMMORTAL_RETAIN_COUNT) {
+    LCReleaseMode mode = __atomic_load_n(&releaseMode, __ATOMIC_ACQUIRE);
+    LCInteger count;
+    if (mode == LCReleaseBackground) {
+      count = __atomic_sub_fetch(&object->rCount, 1, __ATOMIC_ACQ_REL);
+    } else {
+      object->rCount = object->rCount - 1;
+      count = object->rCount;
+    }
+    if (count == 0) {
+      if (mode == LCReleaseImmediate || !releaseQueuePush(object)) {
+        objectDestroy(object);
+      }
+      return NULL;
+    } else if (cycleCollectionEnabled && mode != LCReleaseBackground) {
+      cycleRootsAdd(object);
+    }
+  }
+  return object;
+}
+
+static bool cycleTraced(LCObjectRef object) {
+  return object && !objectIsTaggedInteger(object) && object->rCount != LC_IMMORTAL_RETAIN_COUNT;
+}
+
+static void cycleStackChild(void *cookie, char *key, LCObjectRef objects[], size_t length, bool composite) {
+  for (LCInteger i=0; i<length; i++) {
+    if (cycleTraced(objects[i]) && objects[i]->extension) {
+      objectStackPush(cookie, objects[i]);
+    }
+  }
+}
+
+// children that can't get an extension are left out of the collection, every later phase skips them too
+static void cycleStackChildWithExtension(void *cookie, char *key, LCObjectRef objects[], size_t length,
+                                         bool composite) {
+  for (LCInteger i=0; i<length; i++) {
+    if (cycleTraced(objects[i]) && objectExtensionCreate(objects[i])) {
+      objectStackPush(cookie, objects[i]);
+    }
+  }
+}
+
+// pushes the children the object holds a retain count on, stubs have none
+static void cycleStackChildren(LCObjectRef object, struct objectStack *stack, childCallback callback) {
+  if (!object->data) {
+    return;
+  }
+  if (object->type->walkReferences) {
+    object->type->walkReferences(object, stack, callback);
+  } else if (object->type->walkChildren) {
+    object->type->walkChildren(object, stack, callback);
+  }
+}
+
+static void cycleMarkGray(LCObjectRef root, struct objectStack *stack) {
+  objectStackPush(stack, root);
+  while (stack->length > 0) {
+    stack->length--;
+    LCObjectRef object = stack->objects[stack->length];
+    if (object->extension->cycleColor == cycleGray) {
+      continue;
+    }
+    object->extension->cycleColor = cycleGray;
+    size_t start = stack->length;
+    cycleStackChildren(object, stack, cycleStackChildWithExtension);
+    for (size_t i=start; i<stack->length; i++) {
+      stack->objects[i]->rCount--;
+    }
+  }
+}
+
+static void cycleScanBlack(LCObjectRef root, struct objectStack *stack) {
+  size_t bottom = stack->length;
+  root->extension->cycleColor = cycleBlack;
+  objectStackPush(stack, root);
+  while (stack->length > bottom) {
+    stack->length--;
+    LCObjectRef object = stack->objects[stack->length];
+    size_t start = stack->length;
+    cycleStackChildren(object, stack, cycleStackChild);
+    size_t end = stack->length;
+    stack->length = start;
+    for (size_t i=start; i<end; i++) {
+      LCObjectRef child = stack->objects[i];
+      child->rCount++;
+      if (child->extension->cycleColor != cycleBlack) {
+        child->extension->cycleColor = cycleBlack;
+        stack->objects[stack->length] = child;
+        stack->length++;
+      }
+    }
+  }
+}
+
+static void cycleScan(LCObjectRef root, struct objectStack *stack, struct objectStack *blackStack) {
+  objectStackPush(stack, root);
+  while (stack->length > 0) {
+    stack->length--;
+    LCObjectRef object = stack->objects[stack->length];
+    if (object->extension->cycleColor != cycleGray) {
+      continue;
+    }
+    if (object->rCount > 0) {
+      cycleScanBlack(object, blackStack);
+    } else {
+      object->extension->cycleColor = cycleWhite;
+      cycleStackChildren(object, stack, cycleStackChild);
+    }
+  }
 }
 
-LCObjectRef objectRetain(LCObjectRef object) {
-  if (object) {
-    object->rCount = object->rCount + 1;
+static void cycleCollectWhite(LCObjectRef root, struct objectStack *stack, struct objectStack *garbage) {
+  objectStackPush(stack, root);
+  while (stack->length > 0) {
+    stack->length--;
+    LCObjectRef object = stack->objects[stack->length];
+    if (object->extension->cycleColor != cycleWhite) {
+      continue;
+    }
+    object->extension->cycleColor = cycleGarbage;
+    objectStackPush(garbage, object);
+    cycleStackChildren(object, stack, cycleStackChild);
   }
-  return object;
 }
 
-static void objectDataDealloc(LCObjectRef object) {
-  if (object->data) {
-    if(object->type->dealloc) {
-      object->type->dealloc(object);
-    } else {
-      lcFree(object->data);
+/*
+ - restores the references held by garbage objects, holds one more reference to each of them while
+   their data is deallocated so none is torn down while others still point to it, then drops it
+ - weak references to the garbage are cleared before any data goes away
+*/
+static void cycleFreeGarbage(struct objectStack *garbage, struct objectStack *stack) {
+  for (size_t i=0; i<garbage->length; i++) {
+    stack->length = 0;
+    cycleStackChildren(garbage->objects[i], stack, cycleStackChild);
+    for (size_t j=0; j<stack->length; j++) {
+      stack->objects[j]->rCount++;
     }
-    object->data = NULL;
+  }
+  for (size_t i=0; i<garbage->length; i++) {
+    garbage->objects[i]->rCount++;
+    weakRefsClear(garbage->objects[i]);
+  }
+  for (size_t i=0; i<garbage->length; i++) {
+    objectDataDealloc(garbage->objects[i]);
+  }
+  for (size_t i=0; i<garbage->length; i++) {
+    objectRelease(garbage->objects[i]);
   }
 }
 
-LCObjectRef objectRelease(LCObjectRef object) {
-  if (object) {
-    object->rCount = object->rCount - 1;
-    if (object->rCount == 0) {
-      objectDataDealloc(object);
-      lcFree(object);
-      return NULL;
+void cycleCollectionSetEnabled(bool enabled) {
+  cycleCollectionEnabled = enabled;
+}
+
+size_t cycleRootsPending() {
+  return cycleRoots.length;
+}
+
+/*
+ - examines the first limit roots buffered by the calling thread, or all of them for limit 0, and
+   returns the number of objects freed
+ - the graphs reachable from them must not be used by other threads meanwhile and the collector
+   does nothing while the release mode is LCReleaseBackground
+*/
+size_t cycleCollect(size_t limit) {
+  if (__atomic_load_n(&releaseMode, __ATOMIC_ACQUIRE) == LCReleaseBackground) {
+    return 0;
+  }
+  size_t length = cycleRoots.length;
+  if (limit > 0 && limit < length) {
+    length = limit;
+  }
+  struct objectStack roots = {NULL, 0, 0};
+  struct objectStack stack = {NULL, 0, 0};
+  struct objectStack blackStack = {NULL, 0, 0};
+  struct objectStack garbage = {NULL, 0, 0};
+  for (size_t i=0; i<length; i++) {
+    LCObjectRef object = cycleRoots.objects[i];
+    struct objectExtension *extension = object->extension;
+    if (extension->cycleColor == cyclePurple && object->rCount > 0) {
+      cycleMarkGray(object, &stack);
+      objectStackPush(&roots, object);
+    } else {
+      extension->cycleBuffered = false;
+      if (extension->cycleColor == cycleDead) {
+        objectFreeHeader(object);
+      } else if (extension->cycleColor == cyclePurple) {
+        extension->cycleColor = cycleBlack;
+      }
     }
   }
-  return object;
+  memmove(cycleRoots.objects, &cycleRoots.objects[length], sizeof(LCObjectRef) * (cycleRoots.length - length));
+  cycleRoots.length = cycleRoots.length - length;
+  for (size_t i=0; i<roots.length; i++) {
+    cycleScan(roots.objects[i], &stack, &blackStack);
+  }
+  for (size_t i=0; i<roots.length; i++) {
+    roots.objects[i]->extension->cycleBuffered = false;
+  }
+  for (size_t i=0; i<roots.length; i++) {
+    cycleCollectWhite(roots.objects[i], &stack, &garbage);
+  }
+  cycleFreeGarbage(&garbage, &stack);
+  lcFree(roots.objects);
+  lcFree(stack.objects);
+  lcFree(blackStack.objects);
+  lcFree(garbage.objects);
+  return garbage.length;
 }
 
 void objectReleaseAlt(void *object) {
@@ -137,16 +1109,69 @@ void objectReleaseAlt(void *object) {
 }
 
 LCInteger objectRetainCount(LCObjectRef object) {
+  if (objectIsTaggedInteger(object)) {
+    return 1;
+  }
   return object->rCount;
 }
 
+static bool objectIsNotLoaded(LCObjectRef object) {
+  return !objectIsTaggedInteger(object) && !object->data;
+}
+
+/*
+ orders two objects of the same type without loading them when at least one is a stub:
+ equal digests are equal objects of types with a compare function and different recorded
+ sort keys decide the order; objects of types without one only ever equal themselves
+*/
+static bool objectCompareWithoutData(LCObjectRef object1, LCObjectRef object2, LCCompare *result) {
+  LCTypeRef type = objectType(object1);
+  if (type != objectType(object2) || (!objectIsNotLoaded(object1) && !objectIsNotLoaded(object2))) {
+    return false;
+  }
+  char *hash1 = _objectHash(object1);
+  char *hash2 = _objectHash(object2);
+  if (type->compare && type->immutable && hash1 && hash2 && strcmp(hash1, hash2) == 0) {
+    *result = LCEqual;
+    return true;
+  }
+  uint64_t key1;
+  uint64_t key2;
+  if (type->sortKey && objectReferenceMeta(object1, LCMetaSortKey, &key1) &&
+      objectReferenceMeta(object2, LCMetaSortKey, &key2) && key1 != key2) {
+    *result = key1 < key2 ? LCSmaller : LCGreater;
+    return true;
+  }
+  return false;
+}
+
+/*
+ types sharing a compare function, like LCString and LCMutableString, compare by it, objects of other
+ types are ordered by their compare function or their type, compare functions only ever see their own types
+*/
+static uintptr_t typeCompareGroup(LCTypeRef type) {
+  return type->compare ? (uintptr_t)type->compare : (uintptr_t)type;
+}
+
 LCCompare objectCompare(LCObjectRef object1, LCObjectRef object2) {
   if (object1 == NULL) {
     return LCSmaller;
   } else if (object2 == NULL) {
     return LCGreater;
   }
-  if(object1->type->compare == NULL) {
+  if (object1 == object2) {
+    return LCEqual;
+  }
+  uintptr_t group1 = typeCompareGroup(objectType(object1));
+  uintptr_t group2 = typeCompareGroup(objectType(object2));
+  if (group1 != group2) {
+    return group1 > group2 ? LCGreater : LCSmaller;
+  }
+  LCCompare result;
+  if (objectCompareWithoutData(object1, object2, &result)) {
+    return result;
+  }
+  if(objectType(object1)->compare == NULL) {
     if(object1 == object2) {
       return LCEqual;
     } else {
@@ -157,17 +1182,45 @@ LCCompare objectCompare(LCObjectRef object1, LCObjectRef object2) {
       }
     }
   } else {
-    return object1->type->compare(object1, object2);    
+    return objectType(object1)->compare(object1, object2);
+  }
+}
+
+// always agrees with objectCompare returning LCEqual, it only gets there faster
+bool objectEqual(LCObjectRef object1, LCObjectRef object2) {
+  if (object1 == object2) {
+    return true;
+  }
+  if (object1 == NULL || object2 == NULL) {
+    return false;
+  }
+  LCTypeRef type = objectType(object1);
+  if (typeCompareGroup(type) != typeCompareGroup(objectType(object2))) {
+    return false;
+  }
+  if (type == objectType(object2) && type->immutable && type->compare) {
+    char *hash1 = _objectHash(object1);
+    char *hash2 = _objectHash(object2);
+    if (hash1 && hash2 && (type->canonical || strcmp(hash1, hash2) == 0)) {
+      return strcmp(hash1, hash2) == 0;
+    }
+  }
+  if (type->equal && type == objectType(object2)) {
+    return type->equal(object1, object2);
   }
+  return objectCompare(object1, object2) == LCEqual;
 }
 
 LCContextRef objectContext(LCObjectRef object) {
+  if (objectIsTaggedInteger(object)) {
+    return NULL;
+  }
   return object->context;
 }
 
 void objectWalkChildren(LCObjectRef object, void *cookie, childCallback callback) {
-  if (object->type->walkChildren) {
-    object->type->walkChildren(object, cookie, callback);
+  if (objectType(object)->walkChildren) {
+    objectType(object)->walkChildren(object, cookie, callback);
   }
 }
 
@@ -176,9 +1229,10 @@ static void objectSerializeWalkingChildren(LCObjectRef object, LCInteger levels,
 }
 
 void objectSerializeToLevels(LCObjectRef object, LCInteger levels, FILE *fpw) {
-  if (object->type->serializeData && object->type->serializationFormat == LCText) {
+  LCTypeRef type = objectType(object);
+  if (type->serializeData && type->serializationFormat == LCText) {
     objectSerializeTextToJson(object, fpw);
-  } else if (object->type->serializeData && object->type->serializationFormat == LCBinary) {
+  } else if (type->serializeData && type->serializationFormat == LCBinary) {
     objectSerializeBinaryData(object, fpw);
   } else {
     objectSerializeWalkingChildren(object, levels, fpw);
@@ -194,7 +1248,7 @@ void objectSerialize(LCObjectRef object, FILE *fpw) {
 }
 
 void objectSerializeBinaryData(LCObjectRef object, FILE *fd) {
-  object->type->serializeData(object, fd);
+  objectType(object)->serializeData(object, fd);
 }
 
 void objectStoreChildren(LCObjectRef object, char *key, LCObjectRef objects[], size_t length) {
@@ -221,7 +1275,10 @@ void objectDeserializeBinaryData(LCObjectRef object, FILE *fd) {
 }
 
 void objectHash(LCObjectRef object, char hashBuffer[HASH_LENGTH]) {
-  if (!_objectHash(object) || !object->type->immutable) {
+  LCTypeRef type = objectType(object);
+  if ((!_objectHash(object) || !type->immutable) && type->hash) {
+    type->hash(object, hashBuffer);
+  } else if (!_objectHash(object) || !type->immutable) {
     void* context = createHashContext();
     FILE *fp = createMemoryWriteStream(context, updateHashContext, NULL);
     objectSerialize(object, fp);
@@ -230,7 +1287,7 @@ void objectHash(LCObjectRef object, char hashBuffer[HASH_LENGTH]) {
   } else {
     strcpy(hashBuffer, _objectHash(object));
   }
-  if (object->type->immutable) {
+  if (type->immutable) {
     _objectSetHash(object, hashBuffer);
   }
 }
@@ -250,10 +1307,43 @@ static void storeChildCallback(void *cookie, char *key, LCObjectRef objects[], s
   }
 }
 
+/*
+ - objects whose children are stored as references keep the meta those references know in a side
+   record next to them, the digest only covers the references so the meta can't be part of the
+   addressed bytes; digests must not depend on what the children have loaded
+ - the side record is written once with the object and read whenever the object is loaded
+*/
+static bool typeHasMetaRecord(LCTypeRef type) {
+  return !type->serializeData && type->walkChildren;
+}
+
+static void objectMetaRecordKey(char hash[HASH_LENGTH], char key[META_RECORD_KEY_LENGTH]) {
+  snprintf(key, META_RECORD_KEY_LENGTH, "%s%s", hash, META_RECORD_SUFFIX);
+}
+
+static void objectStoreReferenceMeta(LCObjectRef object, LCStoreRef store, char hash[HASH_LENGTH]) {
+  char metaKey[META_RECORD_KEY_LENGTH];
+  objectMetaRecordKey(hash, metaKey);
+  FILE *fp = storeWriteData(store, objectType(object), metaKey);
+  if (fp) {
+    objectSerializeReferenceMeta(object, fp, objectWalkChildren);
+    fclose(fp);
+  }
+}
+
+static void objectLoadReferenceMeta(LCObjectRef object, FILE *fp) {
+  if (fp) {
+    if (object->data) {
+      objectDeserializeReferenceMeta(object, fp, objectWalkChildren);
+    }
+    fclose(fp);
+  }
+}
+
 static void objectStoreWithCompositeParam(LCObjectRef object, bool composite, LCContextRef context) {
   char hash[HASH_LENGTH];
   objectHash(object, hash);
-  if (!object->type->immutable) {
+  if (!objectImmutable(object)) {
     _objectSetHash(object, hash);
   }
   if (storeFileExists(context->store, objectType(object), hash)) {
@@ -262,8 +1352,13 @@ static void objectStoreWithCompositeParam(LCObjectRef object, bool composite, LC
   FILE* fp = storeWriteData(context->store, objectType(object), hash);
   if (composite) {
     objectSerializeAsComposite(object, fp);
+  } else if (objectType(object)->serializeData) {
+    objectSerialize(object, fp);
   } else {
     objectSerialize(object, fp);
+    if (typeHasMetaRecord(objectType(object))) {
+      objectStoreReferenceMeta(object, context->store, hash);
+    }
     objectWalkChildren(object, context, storeChildCallback);
   }
   fclose(fp);
@@ -284,18 +1379,157 @@ void objectsStore(LCObjectRef objects[], size_t length, LCContextRef context) {
 }
 
 void objectCache(LCObjectRef object) {
-  if (!object->data) {
+  if (!objectIsTaggedInteger(object) && !object->data) {
     LCContextRef context = objectContext(object);
     if (context) {
       FILE* fp = storeReadData(context->store, objectType(object), _objectHash(object));
       objectDeserialize(object, fp);
       fclose(fp);
+      if (typeHasMetaRecord(objectType(object))) {
+        char metaKey[META_RECORD_KEY_LENGTH];
+        objectMetaRecordKey(_objectHash(object), metaKey);
+        objectLoadReferenceMeta(object, storeReadData(context->store, objectType(object), metaKey));
+      }
+      objectCacheLoaded(object);
+    }
+  }
+}
+
+static bool objectIsStub(LCObjectRef object) {
+  return object && !objectIsTaggedInteger(object) && !object->data && objectContext(object) && _objectHash(object);
+}
+
+/*
+ loads every stub among objects with one storeReadManyData call per store,
+ objects that are already loaded are skipped
+*/
+void objectsCache(LCObjectRef objects[], size_t length) {
+  if (length == 0) {
+    return;
+  }
+  LCObjectRef *pending = malloc(sizeof(LCObjectRef) * length);
+  LCObjectRef *batch = malloc(sizeof(LCObjectRef) * length * 2);
+  LCTypeRef *types = malloc(sizeof(LCTypeRef) * length * 2);
+  char **hashes = malloc(sizeof(char*) * length * 2);
+  FILE **fds = malloc(sizeof(FILE*) * length * 2);
+  char (*metaKeys)[META_RECORD_KEY_LENGTH] = malloc(sizeof(char[META_RECORD_KEY_LENGTH]) * length);
+  if (!pending || !batch || !types || !hashes || !fds || !metaKeys) {
+    perror("objectsCache");
+    length = 0;
+  }
+  size_t pendingLength = 0;
+  for (size_t i=0; i<length; i++) {
+    if (objectIsStub(objects[i])) {
+      pending[pendingLength] = objects[i];
+      pendingLength++;
+    }
+  }
+  while (pendingLength > 0) {
+    LCStoreRef store = objectContext(pending[0])->store;
+    size_t batchLength = 0;
+    size_t remaining = 0;
+    size_t metaLength = 0;
+    for (size_t i=0; i<pendingLength; i++) {
+      if (objectContext(pending[i])->store == store) {
+        batch[batchLength] = pending[i];
+        types[batchLength] = objectType(pending[i]);
+        hashes[batchLength] = _objectHash(pending[i]);
+        batchLength++;
+      } else {
+        pending[remaining] = pending[i];
+        remaining++;
+      }
+    }
+    // side records of meta are read in the same batch, right after the objects they belong to
+    size_t readLength = batchLength;
+    for (size_t i=0; i<batchLength; i++) {
+      if (typeHasMetaRecord(types[i])) {
+        objectMetaRecordKey(hashes[i], metaKeys[metaLength]);
+        batch[readLength] = batch[i];
+        types[readLength] = types[i];
+        hashes[readLength] = metaKeys[metaLength];
+        metaLength++;
+        readLength++;
+      }
+    }
+    storeReadManyData(store, types, hashes, fds, readLength);
+    for (size_t i=0; i<batchLength; i++) {
+      if (fds[i]) {
+        if (!batch[i]->data) {
+          objectDeserialize(batch[i], fds[i]);
+          objectCacheLoaded(batch[i]);
+        }
+        fclose(fds[i]);
+      }
+    }
+    for (size_t i=batchLength; i<readLength; i++) {
+      objectLoadReferenceMeta(batch[i], fds[i]);
+    }
+    pendingLength = remaining;
+  }
+  lcFree(metaKeys);
+  lcFree(pending);
+  lcFree(batch);
+  lcFree(types);
+  lcFree(hashes);
+  lcFree(fds);
+}
+
+struct objectPrefetchLevel {
+  LCObjectRef *objects;
+  size_t length;
+  size_t capacity;
+};
+
+static void objectPrefetchChildCallback(void *cookie, char *key, LCObjectRef objects[], size_t length, bool composite) {
+  struct objectPrefetchLevel *level = cookie;
+  if (level->length + length > level->capacity) {
+    size_t capacity = (level->length + length) * 2;
+    LCObjectRef *levelObjects = realloc(level->objects, sizeof(LCObjectRef) * capacity);
+    if (!levelObjects) {
+      perror("objectPrefetch");
+      return;
+    }
+    level->objects = levelObjects;
+    level->capacity = capacity;
+  }
+  memcpy(&level->objects[level->length], objects, sizeof(LCObjectRef) * length);
+  level->length = level->length + length;
+}
+
+/*
+ loads object and its descendants down to depth levels below it, every level of the graph is read
+ with one objectsCache call instead of one store read per child when the child is first used
+*/
+void objectPrefetch(LCObjectRef object, LCInteger depth) {
+  struct objectPrefetchLevel level = {.objects = NULL, .length = 0, .capacity = 0};
+  objectPrefetchChildCallback(&level, NULL, &object, 1, false);
+  for (LCInteger i=0; i<=depth && level.length > 0; i++) {
+    objectsCache(level.objects, level.length);
+    if (i == depth) {
+      break;
+    }
+    struct objectPrefetchLevel next = {.objects = NULL, .length = 0, .capacity = 0};
+    for (size_t j=0; j<level.length; j++) {
+      LCObjectRef each = level.objects[j];
+      if (each && (objectIsTaggedInteger(each) || each->data)) {
+        objectWalkChildren(each, &next, objectPrefetchChildCallback);
+      }
     }
+    lcFree(level.objects);
+    level = next;
   }
+  lcFree(level.objects);
 }
 
 void objectDeleteCache(LCObjectRef object, LCContextRef context) {
+  if (objectIsTaggedInteger(object)) {
+    return;
+  }
   if (storeFileExists(context->store, objectType(object), _objectHash(object))) {
+    if (object->context != context) {
+      contextIdentityRemove(object);
+    }
     object->context = context;
     objectDataDealloc(object);
   }
@@ -314,8 +1548,320 @@ static int objectCompareFun(const void * elem1, const void * elem2) {
   return 0;
 }
 
+static void objectsInsertionSort(LCObjectRef objects[], size_t length) {
+  for (size_t i=1; i<length; i++) {
+    LCObjectRef object = objects[i];
+    size_t j = i;
+    while (j > 0 && objectCompare(objects[j-1], object) == LCGreater) {
+      objects[j] = objects[j-1];
+      j--;
+    }
+    objects[j] = object;
+  }
+}
+
+// takes from left on ties so merging keeps equal objects in their original order
+static void objectsMerge(LCObjectRef left[], size_t leftLength, LCObjectRef right[], size_t rightLength,
+                         LCObjectRef result[]) {
+  size_t l = 0;
+  size_t r = 0;
+  size_t i = 0;
+  while (l < leftLength && r < rightLength) {
+    if (objectCompare(right[r], left[l]) == LCSmaller) {
+      result[i++] = right[r++];
+    } else {
+      result[i++] = left[l++];
+    }
+  }
+  memcpy(&result[i], &left[l], sizeof(LCObjectRef) * (leftLength - l));
+  i = i + leftLength - l;
+  memcpy(&result[i], &right[r], sizeof(LCObjectRef) * (rightLength - r));
+}
+
+// stable, buffer must have room for length objects
+static void objectsMergeSort(LCObjectRef objects[], LCObjectRef buffer[], size_t length) {
+  if (length <= SORT_INSERTION_LENGTH) {
+    objectsInsertionSort(objects, length);
+    return;
+  }
+  size_t half = length / 2;
+  objectsMergeSort(objects, buffer, half);
+  objectsMergeSort(&objects[half], &buffer[half], length - half);
+  if (objectCompare(objects[half-1], objects[half]) != LCGreater) {
+    return;
+  }
+  objectsMerge(objects, half, &objects[half], length - half, buffer);
+  memcpy(objects, buffer, sizeof(LCObjectRef) * length);
+}
+
+/*
+ - runs holds runCount+1 boundaries, run i covers runs[i]..runs[i+1]
+ - every pass merges pairs of neighbouring runs from objects into buffer, then the two swap
+*/
+struct objectsParallelSort {
+  LCObjectRef *objects;
+  LCObjectRef *buffer;
+  size_t *runs;
+  size_t runCount;
+};
+
+static void objectsSortRunChunk(void *cookie, LCInteger chunk, size_t start, size_t end) {
+  struct objectsParallelSort *sort = cookie;
+  objectsMergeSort(&sort->objects[start], &sort->buffer[start], end - start);
+  sort->runs[chunk+1] = end;
+}
+
+static void objectsMergeRunsChunk(void *cookie, LCInteger chunk, size_t start, size_t end) {
+  struct objectsParallelSort *sort = cookie;
+  for (size_t pair=start; pair<end; pair++) {
+    size_t from = sort->runs[pair*2];
+    size_t middle = sort->runs[pair*2+1];
+    size_t to = pair*2+2 <= sort->runCount ? sort->runs[pair*2+2] : middle;
+    objectsMerge(&sort->objects[from], middle - from, &sort->objects[middle], to - middle, &sort->buffer[from]);
+  }
+}
+
+static void objectsParallelMergeSort(LCObjectRef objects[], size_t length, size_t chunks) {
+  LCObjectRef *buffer = malloc(sizeof(LCObjectRef) * length);
+  size_t *runs = malloc(sizeof(size_t) * (chunks + 1));
+  if (!buffer || !runs) {
+    perror("objectsParallelMergeSort");
+    lcFree(buffer);
+    lcFree(runs);
+    qsort(objects, length, sizeof(void*), objectCompareFun);
+    return;
+  }
+  struct objectsParallelSort sort = {
+    .objects = objects,
+    .buffer = buffer,
+    .runs = runs,
+    .runCount = chunks
+  };
+  runs[0] = 0;
+  parallelFor(length, SORT_PARALLEL_MIN_CHUNK, &sort, objectsSortRunChunk);
+  while (sort.runCount > 1) {
+    parallelFor(sort.runCount / 2 + sort.runCount % 2, 1, &sort, objectsMergeRunsChunk);
+    size_t runCount = sort.runCount / 2 + sort.runCount % 2;
+    for (size_t i=0; i<=runCount; i++) {
+      runs[i] = runs[i*2 <= sort.runCount ? i*2 : sort.runCount];
+    }
+    sort.runCount = runCount;
+    LCObjectRef *sorted = sort.buffer;
+    sort.buffer = sort.objects;
+    sort.objects = sorted;
+  }
+  if (sort.objects != objects) {
+    memcpy(objects, sort.objects, sizeof(LCObjectRef) * length);
+  }
+  lcFree(runs);
+  lcFree(buffer);
+}
+
+struct objectSortKey {
+  uint64_t key;
+  LCObjectRef object;
+};
+
+/*
+ least significant byte first radix sort over the keys, bytes every key has in common are skipped;
+ returns whichever of keys and buffer holds the result
+*/
+static struct objectSortKey* objectsRadixSort(struct objectSortKey keys[], struct objectSortKey buffer[],
+                                              size_t length) {
+  size_t (*counts)[256] = calloc(8, sizeof(size_t[256]));
+  if (!counts) {
+    perror("objectsRadixSort");
+    return NULL;
+  }
+  for (size_t i=0; i<length; i++) {
+    for (LCInteger byte=0; byte<8; byte++) {
+      counts[byte][(keys[i].key >> (byte*8)) & 0xff]++;
+    }
+  }
+  for (LCInteger byte=0; byte<8; byte++) {
+    if (counts[byte][(keys[0].key >> (byte*8)) & 0xff] == length) {
+      continue;
+    }
+    size_t offset = 0;
+    for (LCInteger digit=0; digit<256; digit++) {
+      size_t count = counts[byte][digit];
+      counts[byte][digit] = offset;
+      offset = offset + count;
+    }
+    for (size_t i=0; i<length; i++) {
+      buffer[counts[byte][(keys[i].key >> (byte*8)) & 0xff]++] = keys[i];
+    }
+    struct objectSortKey *sorted = buffer;
+    buffer = keys;
+    keys = sorted;
+  }
+  lcFree(counts);
+  return keys;
+}
+
+/*
+ - level is the key level being sorted, keys and objects point to the same range of the input
+ - buffer has room for the length objects of the input, it is allocated for the first run of equal
+   keys that is sorted by compare
+*/
+struct objectsKeySort {
+  LCInteger level;
+  struct objectSortKey *keys;
+  size_t length;
+  bool stable;
+  LCObjectRef *buffer;
+};
+
+static void objectsSortKeyChunk(void *cookie, LCInteger chunk, size_t start, size_t end) {
+  struct objectsKeySort *sort = cookie;
+  for (size_t i=start; i<end; i++) {
+    sort->keys[i].key = objectType(sort->keys[i].object)->sortKey(sort->keys[i].object, sort->level);
+  }
+}
+
+static void objectsSortEqualKeys(struct objectsKeySort *sort, LCObjectRef objects[], size_t length) {
+  if (sort->stable && !sort->buffer) {
+    sort->buffer = malloc(sizeof(LCObjectRef) * sort->length);
+  }
+  if (sort->stable && sort->buffer) {
+    objectsMergeSort(objects, sort->buffer, length);
+  } else if (sort->stable) {
+    objectsInsertionSort(objects, length);
+  } else {
+    qsort(objects, length, sizeof(void*), objectCompareFun);
+  }
+}
+
+/*
+ radix sorts keys by their key at level and writes the objects in order, runs of equal keys are
+ sorted by the keys of the next level until they are short, have run out of key levels or share
+ a zero key, which ends every key; the rest is left to compare
+*/
+static bool objectsSortKeyLevel(struct objectsKeySort *sort, struct objectSortKey keys[],
+                                struct objectSortKey buffer[], LCObjectRef objects[], size_t length) {
+  struct objectsKeySort levelSort = *sort;
+  levelSort.keys = keys;
+  parallelFor(length, SORT_PARALLEL_MIN_CHUNK, &levelSort, objectsSortKeyChunk);
+  struct objectSortKey *sorted = objectsRadixSort(keys, buffer, length);
+  if (!sorted) {
+    return false;
+  }
+  bool success = true;
+  if (sorted != keys) {
+    memcpy(keys, sorted, sizeof(struct objectSortKey) * length);
+  }
+  levelSort.level = sort->level + 1;
+  size_t start = 0;
+  for (size_t i=1; i<=length && success; i++) {
+    if (i < length && keys[i].key == keys[start].key) {
+      continue;
+    }
+    size_t runLength = i - start;
+    if (runLength > SORT_INSERTION_LENGTH && levelSort.level < SORT_KEY_LEVELS && keys[start].key != 0) {
+      success = objectsSortKeyLevel(&levelSort, &keys[start], &buffer[start], &objects[start], runLength);
+    } else {
+      for (size_t k=start; k<i; k++) {
+        objects[k] = keys[k].object;
+      }
+      if (runLength > 1) {
+        objectsSortEqualKeys(&levelSort, &objects[start], runLength);
+      }
+    }
+    start = i;
+  }
+  sort->buffer = levelSort.buffer;
+  return success;
+}
+
+static bool objectsSortByKey(LCObjectRef objects[], size_t length, bool stable) {
+  struct objectSortKey *keys = malloc(sizeof(struct objectSortKey) * length * 2);
+  if (!keys) {
+    return false;
+  }
+  for (size_t i=0; i<length; i++) {
+    keys[i].object = objects[i];
+  }
+  struct objectsKeySort sort = {
+    .level = 0,
+    .keys = keys,
+    .length = length,
+    .stable = stable,
+    .buffer = NULL
+  };
+  bool sorted = objectsSortKeyLevel(&sort, keys, &keys[length], objects, length);
+  if (!sorted) {
+    for (size_t i=0; i<length; i++) {
+      objects[i] = keys[i].object;
+    }
+  }
+  lcFree(sort.buffer);
+  lcFree(keys);
+  return sorted;
+}
+
+/*
+ loads the data of every object so the sorting threads only ever read it, objects from a context are
+ pinned until objectsSortWithStability is done so a cache budget can't evict them while threads run,
+ returns the type all objects share or NULL if they have different types or some are NULL
+*/
+static LCTypeRef objectsSortLoad(LCObjectRef objects[], size_t length) {
+  LCTypeRef type = objectType(objects[0]);
+  objectsPin(objects, length);
+  for (size_t i=0; i<length; i++) {
+    if (!objects[i]) {
+      type = NULL;
+      continue;
+    }
+    if (objectType(objects[i]) != type) {
+      type = NULL;
+    }
+    objectData(objects[i]);
+  }
+  return type;
+}
+
+static void objectsSortByCompare(LCObjectRef objects[], size_t length, bool stable) {
+  size_t chunks = parallelChunkCount(length, SORT_PARALLEL_MIN_CHUNK);
+  if (chunks > 1) {
+    objectsParallelMergeSort(objects, length, chunks);
+  } else if (stable) {
+    LCObjectRef *buffer = malloc(sizeof(LCObjectRef) * length);
+    if (buffer) {
+      objectsMergeSort(objects, buffer, length);
+      lcFree(buffer);
+    } else {
+      perror("objectsSortStable");
+      objectsInsertionSort(objects, length);
+    }
+  } else {
+    qsort(objects, length, sizeof(void*), objectCompareFun);
+  }
+}
+
+// every object objectsSortLoad pinned is unpinned once here, whichever way the objects were sorted
+static void objectsSortWithStability(LCObjectRef objects[], size_t length, bool stable) {
+  if (length < 2) {
+    return;
+  }
+  LCTypeRef type = objectsSortLoad(objects, length);
+  if (!type || !type->sortKey || !objectsSortByKey(objects, length, stable)) {
+    objectsSortByCompare(objects, length, stable);
+  }
+  objectsUnpin(objects, length);
+}
+
+/*
+ - objects of a type with a sortKey are radix sorted by key first, so compare only runs for equal keys
+ - large arrays of other objects are merge sorted in parallel, every chunk on its own thread
+ - compare may be called from several threads at once, the objects' data is loaded before
+*/
 void objectsSort(LCObjectRef objects[], size_t length) {
-  qsort(objects, length, sizeof(void*), objectCompareFun);
+  objectsSortWithStability(objects, length, false);
+}
+
+// like objectsSort but objects that compare equal keep their order
+void objectsSortStable(LCObjectRef objects[], size_t length) {
+  objectsSortWithStability(objects, length, true);
 }
 
 bool objectHashEqual(LCObjectRef object1, LCObjectRef object2) {
@@ -326,6 +1872,127 @@ bool objectHashEqual(LCObjectRef object1, LCObjectRef object2) {
   return strcmp(hash1, hash2)==0;
 }
 
+/*
+ - an object's digest can be trusted without loading it if the object is immutable or an unloaded stub
+ - mutable objects that are loaded may have changed since their hash was stored
+*/
+static bool objectKnownHash(LCObjectRef object, char hashBuffer[HASH_LENGTH]) {
+  if (_objectHash(object) && !object->data) {
+    strcpy(hashBuffer, _objectHash(object));
+    return true;
+  }
+  if (objectImmutable(object)) {
+    objectHash(object, hashBuffer);
+    return true;
+  }
+  return false;
+}
+
+struct graphDiffChildren {
+  size_t length;
+  char **keys;
+  LCObjectRef **objects;
+  size_t *lengths;
+};
+
+static void graphDiffChildCallback(void *cookie, char *key, LCObjectRef objects[], size_t length, bool composite) {
+  struct graphDiffChildren *children = (struct graphDiffChildren*)cookie;
+  size_t i = children->length;
+  children->keys = realloc(children->keys, sizeof(char*) * (i+1));
+  children->objects = realloc(children->objects, sizeof(LCObjectRef*) * (i+1));
+  children->lengths = realloc(children->lengths, sizeof(size_t) * (i+1));
+  children->keys[i] = key;
+  children->objects[i] = malloc(sizeof(LCObjectRef) * length);
+  memcpy(children->objects[i], objects, sizeof(LCObjectRef) * length);
+  children->lengths[i] = length;
+  children->length = i+1;
+}
+
+static void graphDiffChildrenFree(struct graphDiffChildren *children) {
+  for (LCInteger i=0; i<children->length; i++) {
+    lcFree(children->objects[i]);
+  }
+  lcFree(children->keys);
+  lcFree(children->objects);
+  lcFree(children->lengths);
+}
+
+static LCInteger graphDiffChildrenIndex(struct graphDiffChildren *children, char *key) {
+  for (LCInteger i=0; i<children->length; i++) {
+    if (strcmp(children->keys[i], key)==0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static void graphDiffPair(LCObjectRef object1, LCObjectRef object2, char *path, void *cookie, graphDiffCallback cb);
+
+static void graphDiffLists(LCObjectRef objects1[], size_t length1, LCObjectRef objects2[], size_t length2,
+                           char *path, char *key, void *cookie, graphDiffCallback cb) {
+  size_t maxLength = length1 > length2 ? length1 : length2;
+  char childPath[strlen(path) + strlen(key) + 24];
+  for (LCInteger i=0; i<maxLength; i++) {
+    sprintf(childPath, "%s%s%s/%i", path, path[0] ? "/" : "", key, i);
+    LCObjectRef child1 = i < length1 ? objects1[i] : NULL;
+    LCObjectRef child2 = i < length2 ? objects2[i] : NULL;
+    graphDiffPair(child1, child2, childPath, cookie, cb);
+  }
+}
+
+static void graphDiffPair(LCObjectRef object1, LCObjectRef object2, char *path, void *cookie, graphDiffCallback cb) {
+  if (object1 == object2) {
+    return;
+  }
+  if (!object1) {
+    cb(cookie, LCDiffAdded, path, NULL, object2);
+    return;
+  }
+  if (!object2) {
+    cb(cookie, LCDiffRemoved, path, object1, NULL);
+    return;
+  }
+  if (objectType(object1) != objectType(object2)) {
+    cb(cookie, LCDiffChanged, path, object1, object2);
+    return;
+  }
+  char hash1[HASH_LENGTH];
+  char hash2[HASH_LENGTH];
+  if (objectKnownHash(object1, hash1) && objectKnownHash(object2, hash2) && strcmp(hash1, hash2)==0) {
+    return;
+  }
+  if (!objectType(object1)->walkChildren) {
+    if (objectCompare(object1, object2) != LCEqual) {
+      cb(cookie, LCDiffChanged, path, object1, object2);
+    }
+    return;
+  }
+  struct graphDiffChildren children1 = {0};
+  struct graphDiffChildren children2 = {0};
+  objectWalkChildren(object1, &children1, graphDiffChildCallback);
+  objectWalkChildren(object2, &children2, graphDiffChildCallback);
+  for (LCInteger i=0; i<children1.length; i++) {
+    LCInteger j = graphDiffChildrenIndex(&children2, children1.keys[i]);
+    if (j == -1) {
+      graphDiffLists(children1.objects[i], children1.lengths[i], NULL, 0, path, children1.keys[i], cookie, cb);
+    } else {
+      graphDiffLists(children1.objects[i], children1.lengths[i], children2.objects[j], children2.lengths[j],
+                     path, children1.keys[i], cookie, cb);
+    }
+  }
+  for (LCInteger j=0; j<children2.length; j++) {
+    if (graphDiffChildrenIndex(&children1, children2.keys[j]) == -1) {
+      graphDiffLists(NULL, 0, children2.objects[j], children2.lengths[j], path, children2.keys[j], cookie, cb);
+    }
+  }
+  graphDiffChildrenFree(&children1);
+  graphDiffChildrenFree(&children2);
+}
+
+void objectGraphDiff(LCObjectRef root1, LCObjectRef root2, void *cookie, graphDiffCallback cb) {
+  graphDiffPair(root1, root2, "", cookie, cb);
+}
+
 char* typeName(LCTypeRef type) {
   if (type->name) {
     return type->name;
@@ -357,10 +2024,16 @@ LCStoreRef storeCreate(void *cookie, writeData writefn, deleteData deletefn, rea
     store->writefn = writefn;
     store->deletefn = deletefn;
     store->readfn = readfn;
+    store->readManyfn = NULL;
   }
   return store;
 }
 
+// stores that can fetch several keys in one round trip should set readManyfn
+void storeSetReadMany(LCStoreRef store, readManyData readManyfn) {
+  store->readManyfn = readManyfn;
+}
+
 bool storeFileExists(LCStoreRef store, LCTypeRef type, char hash[HASH_LENGTH]) {
   FILE *fp = storeReadData(store, type, hash);
   if (fp) {
@@ -383,15 +2056,35 @@ FILE* storeReadData(LCStoreRef store, LCTypeRef type, char hash[HASH_LENGTH]) {
   return store->readfn(store->cookie, type, hash);
 }
 
+// without a readManyfn the keys are read one by one
+void storeReadManyData(LCStoreRef store, LCTypeRef types[], char *hashes[], FILE *fds[], size_t length) {
+  if (store->readManyfn) {
+    store->readManyfn(store->cookie, types, hashes, fds, length);
+    return;
+  }
+  for (size_t i=0; i<length; i++) {
+    fds[i] = store->readfn(store->cookie, types[i], hashes[i]);
+  }
+}
+
 LCContextRef contextCreate(LCStoreRef store, stringToType funs[], size_t length) {
+  stringToType coreFun = &coreStringToType;
   if (!funs) {
-    stringToType coreFun = &coreStringToType;
     funs = &coreFun;
     length = 1;
   }
   LCContextRef context = malloc(sizeof(struct LCContext) + length * sizeof(stringToType));
   if (context) {
     context->store = store;
+    context->cacheStats = (LCCacheStats){.budget = 0};
+    context->cacheHead = NULL;
+    context->cacheTail = NULL;
+    context->cacheLength = 0;
+    pthread_mutex_init(&context->identityLock, NULL);
+    context->identitySlots = NULL;
+    context->identityCapacity = 0;
+    context->identityLength = 0;
+    context->sharesIdentities = false;
     context->translationFunsLength = length;
     for (LCInteger i=0; i<length; i++) {
       context->translationFuns[i] = funs[i];
@@ -410,9 +2103,35 @@ LCTypeRef contextStringToType(LCContextRef context, char *typeString) {
   return NULL;
 }
 
+/*
+ limits the data of immutable objects without children loaded from the context's store to about
+ budget bytes, the least recently used are evicted back to stubs and load again on their next use;
+ pointers into an object's data, like LCStringChars, stay valid across later loads only while the
+ object is pinned. A budget of 0, the default, keeps everything loaded.
+*/
+void contextSetCacheBudget(LCContextRef context, size_t budget) {
+  context->cacheStats.budget = budget;
+  contextCacheEvict(context);
+}
+
+/*
+ - a context that shares identities gives every reference to a digest of an immutable type the same
+   object, otherwise every reference gets a stub of its own; off by default
+ - the identity table has a lock but retain counts are only atomic in LCReleaseBackground, several
+   threads may only fault references from a sharing context in that mode
+*/
+void contextSetSharesIdentities(LCContextRef context, bool shares) {
+  context->sharesIdentities = shares;
+}
+
+LCCacheStats contextCacheStats(LCContextRef context) {
+  return context->cacheStats;
+}
+
 LCTypeRef coreStringToType(char *typeString) {
-  LCTypeRef coreTypes[] = {LCTypeArray, LCTypeData, LCTypeKeyValue, LCTypeMutableArray, LCTypeMutableDictionary, LCTypeString};
-  for (LCInteger i=0; i<6; i++) {
+  LCTypeRef coreTypes[] = {LCTypeArray, LCTypeData, LCTypeKeyValue, LCTypeMutableArray, LCTypeMutableDictionary,
+    LCTypeMutableString, LCTypeNumber, LCTypeRecordBatch, LCTypeString, LCTypeTypedArray};
+  for (LCInteger i=0; i<10; i++) {
     if (strcmp(typeString, typeName(coreTypes[i]))==0) {
       return coreTypes[i]; 
     }
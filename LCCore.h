@@ -8,9 +8,19 @@
 #define HASH_LENGTH 41
 #define LC_HASH_BYTE_LENGTH 20
 
+// integers in this range are encoded directly in the bits of an LCObjectRef
+#define LC_TAGGED_INTEGER_MIN (-((int64_t)1 << 62))
+#define LC_TAGGED_INTEGER_MAX (((int64_t)1 << 62) - 1)
+
+// objects with this retain count are never deallocated, retain and release leave them untouched
+#define LC_IMMORTAL_RETAIN_COUNT -1
+
 extern char *LCUnnamedObject;
 //Errors
 #define ErrorObjectImmutable "can't add mutable objects to immutable object"
+#define ErrorNoRegion "objectAutorelease without a region"
+#define ErrorInvalidTypedArray "invalid typed array header"
+#define ErrorRecordBatchRow "record batch rows must be LCMutableDictionary"
 
 typedef int LCInteger;
 typedef unsigned char LCByte;
@@ -26,6 +36,12 @@ typedef enum {
   LCText
 } LCFormat;
 
+typedef enum {
+  LCDiffAdded,
+  LCDiffRemoved,
+  LCDiffChanged
+} LCDiffType;
+
 typedef struct LCObject* LCObjectRef;
 typedef struct LCType* LCTypeRef;
 typedef struct LCStore*  LCStoreRef;
@@ -39,26 +55,47 @@ typedef void(*writeStreamFun)(void *cookie, LCByte data[], size_t length);
 typedef void(*closeStreamFun)(void *cookie);
 
 typedef LCObjectRef(*LCCreateEachCb)(LCInteger i, void* info, LCObjectRef each);
+typedef bool(*LCFilterEachCb)(LCInteger i, void* info, LCObjectRef each);
+typedef void(*LCReduceCb)(LCInteger i, void* info, void *accumulator, LCObjectRef each);
+typedef void(*LCCombineCb)(void* info, void *accumulator, void *other);
 
 typedef FILE*(*writeData)(void *cookie, LCTypeRef type, char *key);
 typedef void(*deleteData)(void *cookie, LCTypeRef type, char *key);
 typedef FILE*(*readData)(void *cookie, LCTypeRef type, char *key);
+// fills fds with a stream for every key or NULL for keys the store does not have
+typedef void(*readManyData)(void *cookie, LCTypeRef types[], char *keys[], FILE *fds[], size_t length);
 
 typedef void (*callback)(void *cookie);
 typedef void(*childCallback) (void *cookie, char *key, LCObjectRef objects[], size_t length, bool composite);
 
 typedef void (*walkChildren)(LCObjectRef object, void *cookie, childCallback cb);
+typedef void(*graphDiffCallback)(void *cookie, LCDiffType diff, char *path, LCObjectRef object1, LCObjectRef object2);
 typedef void (*storeChildren)(LCObjectRef object, char *key, LCObjectRef objects[], size_t length);
 
 /*
  - a type either implements serialize/deserializeData or walk/storeChildren but never both.
  - serializationFormat decides whether an object can be rendered as a composite or not
+ - canonical is set by immutable types whose equal objects always serialize to the same bytes,
+   objectEqual then tells objects with known digests apart without loading them; digests only
+   stand in for compare, objects of types without compare are equal to themselves alone
  - initData should return any data the object needs to start deserialization
  - dealloc should always release all child objects and free the objects data if possible
+ - hash is optional and computes the digest of serializeData's output without going through a stream
+ - equal is optional and answers objectEqual for two objects of the type faster than a full compare
+ - dataSize is optional and estimates the bytes the object's data holds, without its children
+ - length is optional and returns the number of characters, bytes, elements or entries the object holds;
+   length, dataSize and the level 0 sortKey are recorded in references to the object so its stubs answer
+   them without loading
+ - sortKey is optional and returns a key that orders like compare: an object with a smaller key at level 0
+   always compares smaller, objects with equal keys at every level up to n are ordered by their key at
+   level n+1; a zero key ends the levels and types with a single level return 0 for every other level
+ - walkReferences is optional and reports exactly the children the object holds a retain count on, the
+   cycle collector traces with it and falls back to walkChildren; types that can't tell report nothing
 */
 struct LCType {
   char* name;
   bool immutable;
+  bool canonical;
   LCFormat serializationFormat;
   void (*dealloc)(LCObjectRef object);
   LCCompare (*compare)(LCObjectRef object1, LCObjectRef object2);
@@ -66,22 +103,131 @@ struct LCType {
   void* (*deserializeData)(LCObjectRef object, FILE *fd);
   void* (*initData)(void);
   walkChildren walkChildren;
+  walkChildren walkReferences;
   storeChildren storeChildren;
+  void (*hash)(LCObjectRef object, char hashBuffer[HASH_LENGTH]);
+  bool (*equal)(LCObjectRef object1, LCObjectRef object2);
+  uint64_t (*sortKey)(LCObjectRef object, LCInteger level);
+  size_t (*dataSize)(LCObjectRef object);
+  size_t (*length)(LCObjectRef object);
   void *meta;
 };
 
+struct objectExtension;
+
+// values a reference records about the object it points to
+typedef enum {
+  LCMetaLength,
+  LCMetaSize,
+  LCMetaSortKey,
+  LCMetaKeysCount
+} LCMetaKey;
+
+/*
+ - the layout is public only so static objects can be initialized at compile time,
+   everything else should go through the object functions
+ - hash is NULL or points to the digest, an empty string means the digest was not computed yet
+ - chunk is the region chunk the object was allocated from, NULL for objects on the heap
+ - extension is NULL until the object uses a cache budget, pins, reference meta or the cycle
+   collector, which keep their state in it
+*/
+struct LCObject {
+  LCTypeRef type;
+  LCInteger rCount;
+  LCContextRef context;
+  char *hash;
+  void *data;
+  struct regionChunk *chunk;
+  struct objectExtension *extension;
+};
+
+/*
+ - budget and used are bytes as estimated by the types' dataSize, resident is the number of
+   objects whose data counts towards used
+ - refaults counts loads of objects whose data had been evicted or deleted from the cache before
+*/
+typedef struct {
+  size_t budget;
+  size_t used;
+  size_t resident;
+  LCInteger loads;
+  LCInteger evictions;
+  LCInteger refaults;
+} LCCacheStats;
+
+/*
+ - LCReleaseImmediate deallocates an object in the objectRelease that drops its count to zero,
+   releasing its children recursively on the calling thread
+ - LCReleaseDeferred queues the object instead, releaseDrain tears queued objects down one at a
+   time and queues children that drop to zero behind them, so no graph is destroyed recursively
+ - LCReleaseBackground drains the queue on a background thread, retain counts are updated
+   atomically in this mode; a context with a cache budget must not be used while its objects
+   are being destroyed in the background; it is the only mode in which several threads may
+   create objects from a context that shares identities, see contextSetSharesIdentities
+*/
+typedef enum {
+  LCReleaseImmediate,
+  LCReleaseDeferred,
+  LCReleaseBackground
+} LCReleaseMode;
+
+#define LC_IMMORTAL_OBJECT_INITIALIZER(typeStruct, hashBuffer, dataStruct) { \
+    .type = &(typeStruct), \
+    .rCount = LC_IMMORTAL_RETAIN_COUNT, \
+    .context = NULL, \
+    .hash = (hashBuffer), \
+    .data = &(dataStruct) \
+  }
+
+/*
+ LCStaticObject defines an immortal object with statically allocated data, the digest is
+ computed on first use into a static buffer; LCStaticRef gives the object's address as a
+ constant expression, so static objects can be elements of other static objects
+*/
+#define LCStaticObject(name, typeStruct, dataStruct) \
+  static char name##Hash[HASH_LENGTH]; \
+  static struct LCObject name##Object = LC_IMMORTAL_OBJECT_INITIALIZER(typeStruct, name##Hash, dataStruct); \
+  static LCObjectRef const name = &name##Object
+
+/*
+ LCStackObject defines an immortal object header on the stack around borrowed data, it is meant
+ for temporary lookup keys and must neither be stored nor retained beyond the enclosing block
+*/
+#define LCStackObject(name, typeStruct, dataStruct) \
+  char name##Hash[HASH_LENGTH] = ""; \
+  struct LCObject name##Object = LC_IMMORTAL_OBJECT_INITIALIZER(typeStruct, name##Hash, dataStruct); \
+  LCObjectRef const name = &name##Object
+
+#define LCStaticRef(name) (&name##Object)
+
 LCObjectRef objectCreate(LCTypeRef type, void* data);
 LCObjectRef objectCreateFromContext(LCContextRef context, LCTypeRef type, char hash[HASH_LENGTH]);
 LCObjectRef objectCreateFromFile(LCContextRef context, LCTypeRef type, FILE *fd);
+LCObjectRef objectCreateTaggedInteger(int64_t value);
+bool objectIsTaggedInteger(LCObjectRef object);
+bool objectIsImmortal(LCObjectRef object);
+int64_t objectTaggedIntegerValue(LCObjectRef object);
 void* objectData(LCObjectRef object);
 LCTypeRef objectType(LCObjectRef object);
 bool objectImmutable(LCObjectRef object);
 bool objectsImmutable(LCObjectRef objects[], size_t length);
 LCObjectRef objectRetain(LCObjectRef object);
+bool objectRetainIfLive(LCObjectRef object);
+LCInteger retainCountAdd(LCInteger *count, LCInteger delta);
 LCObjectRef objectRelease(LCObjectRef object);
+LCObjectRef objectAutorelease(LCObjectRef object);
+void regionBegin(void);
+void regionEnd(void);
+void releaseSetMode(LCReleaseMode mode);
+size_t releaseDrain(size_t limit);
+size_t releasePending(void);
+void cycleCollectionSetEnabled(bool enabled);
+size_t cycleCollect(size_t limit);
+size_t cycleRootsPending(void);
 void objectReleaseAlt(void *object);
 LCInteger objectRetainCount(LCObjectRef object);
 LCCompare objectCompare(LCObjectRef object1, LCObjectRef object2);
+bool objectEqual(LCObjectRef object1, LCObjectRef object2);
 LCContextRef objectContext(LCObjectRef object);
 void objectSerializeToLevels(LCObjectRef object, LCInteger levels, FILE *fpw);
 void objectSerializeAsComposite(LCObjectRef object, FILE *fpw);
@@ -90,15 +236,28 @@ void objectSerializeBinaryData(LCObjectRef object, FILE *fd);
 void objectDeserializeBinaryData(LCObjectRef object, FILE *fd);
 void objectDeserialize(LCObjectRef object, FILE* fd);
 void objectStoreChildren(LCObjectRef object, char *key, LCObjectRef objects[], size_t length);
+void objectWalkChildren(LCObjectRef object, void *cookie, childCallback callback);
 void objectHash(LCObjectRef object, char hashBuffer[HASH_LENGTH]);
 LCStringRef objectCreateHashString(LCObjectRef object);
 void objectStore(LCObjectRef object, LCContextRef context);
 void objectStoreAsComposite(LCObjectRef object, LCContextRef context);
 void objectsStore(LCObjectRef objects[], size_t length, LCContextRef context);
 void objectCache(LCObjectRef object);
+void objectsCache(LCObjectRef objects[], size_t length);
+void objectPrefetch(LCObjectRef object, LCInteger depth);
+char* objectMetaKeyName(LCMetaKey key);
+bool objectStubMeta(LCObjectRef object, LCMetaKey key, uint64_t *value);
+void objectSetStubMeta(LCObjectRef object, LCMetaKey key, uint64_t value);
+bool objectReferenceMeta(LCObjectRef object, LCMetaKey key, uint64_t *value);
+void objectPin(LCObjectRef object);
+void objectUnpin(LCObjectRef object);
+void objectsPin(LCObjectRef objects[], size_t length);
+void objectsUnpin(LCObjectRef objects[], size_t length);
 void objectDeleteCache(LCObjectRef object, LCContextRef context);
 void objectsSort(LCObjectRef objects[], size_t length);
+void objectsSortStable(LCObjectRef objects[], size_t length);
 bool objectHashEqual(LCObjectRef object1, LCObjectRef object2);
+void objectGraphDiff(LCObjectRef root1, LCObjectRef root2, void *cookie, graphDiffCallback cb);
 char* typeName(LCTypeRef type);
 bool typeImmutable(LCTypeRef type);
 LCFormat typeSerializationFormat(LCTypeRef type);
@@ -109,9 +268,14 @@ bool storeFileExists(LCStoreRef store, LCTypeRef type, char hash[HASH_LENGTH]);
 FILE* storeWriteData(LCStoreRef store, LCTypeRef type, char hash[HASH_LENGTH]);
 void storeDeleteData(LCStoreRef store, LCTypeRef type, char hash[HASH_LENGTH]);
 FILE* storeReadData(LCStoreRef store, LCTypeRef type, char hash[HASH_LENGTH]);
+void storeSetReadMany(LCStoreRef store, readManyData readManyfn);
+void storeReadManyData(LCStoreRef store, LCTypeRef types[], char *hashes[], FILE *fds[], size_t length);
 
 LCContextRef contextCreate(LCStoreRef store, stringToType translateFuns[], size_t length);
 LCTypeRef contextStringToType(LCContextRef context, char* typeString);
+void contextSetCacheBudget(LCContextRef context, size_t budget);
+LCCacheStats contextCacheStats(LCContextRef context);
+void contextSetSharesIdentities(LCContextRef context, bool shares);
 
 LCTypeRef coreStringToType(char* typeString);
 
@@ -11,6 +11,7 @@ typedef struct data* dataRef;
 void dataSerialize(LCObjectRef object, FILE *fp);
 void* dataDeserialize(LCDataRef data, FILE *fd);
 void dataDealloc(LCObjectRef data);
+size_t dataDataSize(LCObjectRef data);
 
 struct data {
   size_t length;
@@ -20,8 +21,11 @@ struct data {
 struct LCType typeData = {
   .name = "LCData",
   .immutable = true,
+  .canonical = true,
   .serializationFormat = LCBinary,
   .dealloc = dataDealloc,
+  .dataSize = dataDataSize,
+  .length = LCDataLength,
   .serializeData = dataSerialize,
   .deserializeData = dataDeserialize
 };
@@ -51,6 +55,10 @@ LCDataRef LCDataCreate(LCByte data[], size_t length) {
 };
 
 size_t LCDataLength(LCDataRef data) {
+  uint64_t length;
+  if (objectStubMeta(data, LCMetaLength, &length)) {
+    return length;
+  }
   dataRef dataStruct = objectData(data);
   return dataStruct->length;
 }
@@ -60,6 +68,11 @@ LCByte* LCDataDataRef(LCDataRef data) {
   return dataStruct->data;
 }
 
+size_t dataDataSize(LCObjectRef data) {
+  dataRef dataStruct = objectData(data);
+  return sizeof(struct data) + dataStruct->length;
+}
+
 void dataDealloc(LCObjectRef data) {
   dataRef dataStruct = objectData(data);
   lcFree(dataStruct->data);
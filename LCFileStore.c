@@ -49,11 +49,12 @@ LCStoreRef LCFileStoreStoreObject(LCFileStoreRef store) {
 }
 
 FILE* fileStoreWrite(void *cookie, LCTypeRef type, char *key) {
-  LCStringRef directoryPath = createDirectoryPath(cookie, type);
+  regionBegin();
+  LCStringRef directoryPath = objectAutorelease(createDirectoryPath(cookie, type));
   makeDirectory(LCStringChars(directoryPath));
-  LCStringRef filePath = createFilePath(cookie, type, key);
+  LCStringRef filePath = objectAutorelease(createFilePath(cookie, type, key));
   FILE *fp = fopen(LCStringChars(filePath), "w");
-  objectRelease(filePath);
+  regionEnd();
   return fp;
 }
 
@@ -0,0 +1,273 @@
+
+#include "LCIterator.h"
+
+typedef struct iteratorData* iteratorDataRef;
+
+void iteratorDealloc(LCObjectRef object);
+
+typedef enum {
+  LCIteratorObjects,
+  LCIteratorMap,
+  LCIteratorFilter,
+  LCIteratorTake,
+  LCIteratorSkip,
+  LCIteratorFlatMap
+} LCIteratorKind;
+
+/*
+ - an iterator either reads objects/length owned by owner or pulls from the source iterator,
+   nothing is produced before LCIteratorNext asks for it
+ - index counts the objects pulled from source and is passed to the callbacks
+ - count is the number of objects left to take or to skip
+ - inner is the iterator of the object flatMap currently expands
+*/
+struct iteratorData {
+  LCIteratorKind kind;
+  LCObjectRef owner;
+  LCObjectRef *objects;
+  size_t length;
+  size_t position;
+  LCIteratorRef source;
+  LCIteratorRef inner;
+  void *info;
+  LCCreateEachCb map;
+  LCFilterEachCb filter;
+  size_t count;
+  LCInteger index;
+};
+
+struct LCType typeIterator = {
+  .name = "LCIterator",
+  .immutable = false,
+  .dealloc = iteratorDealloc
+};
+
+LCTypeRef LCTypeIterator = &typeIterator;
+
+static iteratorDataRef iteratorCreateStruct(LCIteratorKind kind, LCIteratorRef source) {
+  iteratorDataRef data = malloc(sizeof(struct iteratorData));
+  if (data) {
+    data->kind = kind;
+    data->owner = NULL;
+    data->objects = NULL;
+    data->length = 0;
+    data->position = 0;
+    data->source = objectRetain(source);
+    data->inner = NULL;
+    data->info = NULL;
+    data->map = NULL;
+    data->filter = NULL;
+    data->count = 0;
+    data->index = 0;
+  }
+  return data;
+}
+
+static LCIteratorRef iteratorCreateFromObjects(LCObjectRef owner, LCObjectRef objects[], size_t length) {
+  iteratorDataRef data = iteratorCreateStruct(LCIteratorObjects, NULL);
+  if (!data) {
+    return NULL;
+  }
+  data->owner = objectRetain(owner);
+  data->objects = objects;
+  data->length = length;
+  return objectCreate(LCTypeIterator, data);
+}
+
+// the array must not be mutated while the iterator is in use
+LCIteratorRef LCIteratorCreateFromArray(LCArrayRef array) {
+  return iteratorCreateFromObjects(array, LCArrayObjects(array), LCArrayLength(array));
+}
+
+struct iteratorChildrenInfo {
+  char *key;
+  LCArrayRef children;
+};
+
+// walkChildren may report arrays that only live during the callback, so they are copied
+static void iteratorChildCallback(void *cookie, char *key, LCObjectRef objects[], size_t length, bool composite) {
+  struct iteratorChildrenInfo *info = cookie;
+  if (strcmp(key, info->key) == 0 && !info->children) {
+    info->children = LCArrayCreate(objects, length);
+  }
+}
+
+/*
+ iterates the children walkChildren reports for key, children of persisted objects stay stubs until
+ a callback or the caller touches their data, so they are faulted in one at a time
+*/
+LCIteratorRef LCIteratorCreateFromChildren(LCObjectRef object, char *key) {
+  struct iteratorChildrenInfo info = {.key = key, .children = NULL};
+  objectWalkChildren(object, &info, iteratorChildCallback);
+  if (!info.children) {
+    return iteratorCreateFromObjects(object, NULL, 0);
+  }
+  LCIteratorRef iterator = LCIteratorCreateFromArray(info.children);
+  objectRelease(info.children);
+  return iterator;
+}
+
+LCIteratorRef LCIteratorCreateMap(LCIteratorRef source, void* info, LCCreateEachCb each) {
+  iteratorDataRef data = iteratorCreateStruct(LCIteratorMap, source);
+  if (!data) {
+    return NULL;
+  }
+  data->info = info;
+  data->map = each;
+  return objectCreate(LCTypeIterator, data);
+}
+
+LCIteratorRef LCIteratorCreateFilter(LCIteratorRef source, void* info, LCFilterEachCb each) {
+  iteratorDataRef data = iteratorCreateStruct(LCIteratorFilter, source);
+  if (!data) {
+    return NULL;
+  }
+  data->info = info;
+  data->filter = each;
+  return objectCreate(LCTypeIterator, data);
+}
+
+LCIteratorRef LCIteratorCreateTake(LCIteratorRef source, size_t count) {
+  iteratorDataRef data = iteratorCreateStruct(LCIteratorTake, source);
+  if (!data) {
+    return NULL;
+  }
+  data->count = count;
+  return objectCreate(LCTypeIterator, data);
+}
+
+LCIteratorRef LCIteratorCreateSkip(LCIteratorRef source, size_t count) {
+  iteratorDataRef data = iteratorCreateStruct(LCIteratorSkip, source);
+  if (!data) {
+    return NULL;
+  }
+  data->count = count;
+  return objectCreate(LCTypeIterator, data);
+}
+
+// each returns either an LCIterator or an LCArray whose objects are produced in its place
+LCIteratorRef LCIteratorCreateFlatMap(LCIteratorRef source, void* info, LCCreateEachCb each) {
+  iteratorDataRef data = iteratorCreateStruct(LCIteratorFlatMap, source);
+  if (!data) {
+    return NULL;
+  }
+  data->info = info;
+  data->map = each;
+  return objectCreate(LCTypeIterator, data);
+}
+
+static LCObjectRef iteratorObjectsNext(iteratorDataRef data) {
+  while (data->position < data->length) {
+    LCObjectRef object = data->objects[data->position];
+    data->position++;
+    if (object) {
+      return objectRetain(object);
+    }
+  }
+  return NULL;
+}
+
+static LCIteratorRef iteratorFromMapped(LCObjectRef mapped) {
+  if (!mapped || objectType(mapped) == LCTypeIterator) {
+    return mapped;
+  }
+  LCIteratorRef iterator = LCIteratorCreateFromArray(mapped);
+  objectRelease(mapped);
+  return iterator;
+}
+
+// returns the next object retained for the caller or NULL at the end, NULL elements are skipped
+LCObjectRef LCIteratorNext(LCIteratorRef iterator) {
+  iteratorDataRef data = objectData(iterator);
+  LCObjectRef object;
+  switch (data->kind) {
+    case LCIteratorObjects:
+      return iteratorObjectsNext(data);
+    case LCIteratorMap:
+      while ((object = LCIteratorNext(data->source))) {
+        LCObjectRef mapped = data->map(data->index, data->info, object);
+        data->index++;
+        objectRelease(object);
+        if (mapped) {
+          return mapped;
+        }
+      }
+      return NULL;
+    case LCIteratorFilter:
+      while ((object = LCIteratorNext(data->source))) {
+        bool selected = data->filter(data->index, data->info, object);
+        data->index++;
+        if (selected) {
+          return object;
+        }
+        objectRelease(object);
+      }
+      return NULL;
+    case LCIteratorTake:
+      if (data->count == 0) {
+        return NULL;
+      }
+      data->count--;
+      return LCIteratorNext(data->source);
+    case LCIteratorSkip:
+      while (data->count > 0) {
+        data->count--;
+        object = LCIteratorNext(data->source);
+        if (!object) {
+          data->count = 0;
+          return NULL;
+        }
+        objectRelease(object);
+      }
+      return LCIteratorNext(data->source);
+    case LCIteratorFlatMap:
+      while (true) {
+        if (data->inner) {
+          object = LCIteratorNext(data->inner);
+          if (object) {
+            return object;
+          }
+          objectRelease(data->inner);
+          data->inner = NULL;
+        }
+        object = LCIteratorNext(data->source);
+        if (!object) {
+          return NULL;
+        }
+        data->inner = iteratorFromMapped(data->map(data->index, data->info, object));
+        data->index++;
+        objectRelease(object);
+      }
+  }
+  return NULL;
+}
+
+LCArrayRef LCIteratorCreateArray(LCIteratorRef iterator) {
+  LCMutableArrayRef collected = LCMutableArrayCreate(NULL, 0);
+  LCObjectRef object;
+  while ((object = LCIteratorNext(iterator))) {
+    LCMutableArrayAddObject(collected, object);
+    objectRelease(object);
+  }
+  LCArrayRef array = LCMutableArrayCreateArray(collected);
+  objectRelease(collected);
+  return array;
+}
+
+void LCIteratorReduce(LCIteratorRef iterator, void* info, void *accumulator, LCReduceCb each) {
+  LCObjectRef object;
+  LCInteger i = 0;
+  while ((object = LCIteratorNext(iterator))) {
+    each(i, info, accumulator, object);
+    i++;
+    objectRelease(object);
+  }
+}
+
+void iteratorDealloc(LCObjectRef object) {
+  iteratorDataRef data = objectData(object);
+  objectRelease(data->owner);
+  objectRelease(data->source);
+  objectRelease(data->inner);
+  lcFree(data);
+}
@@ -0,0 +1,22 @@
+
+#ifndef LivelyC_LCIterator_h
+#define LivelyC_LCIterator_h
+
+#include "LCCore.h"
+#include "LCArray.h"
+
+typedef LCObjectRef LCIteratorRef;
+extern LCTypeRef LCTypeIterator;
+
+LCIteratorRef LCIteratorCreateFromArray(LCArrayRef array);
+LCIteratorRef LCIteratorCreateFromChildren(LCObjectRef object, char *key);
+LCIteratorRef LCIteratorCreateMap(LCIteratorRef source, void* info, LCCreateEachCb each);
+LCIteratorRef LCIteratorCreateFilter(LCIteratorRef source, void* info, LCFilterEachCb each);
+LCIteratorRef LCIteratorCreateTake(LCIteratorRef source, size_t count);
+LCIteratorRef LCIteratorCreateSkip(LCIteratorRef source, size_t count);
+LCIteratorRef LCIteratorCreateFlatMap(LCIteratorRef source, void* info, LCCreateEachCb each);
+LCObjectRef LCIteratorNext(LCIteratorRef iterator);
+LCArrayRef LCIteratorCreateArray(LCIteratorRef iterator);
+void LCIteratorReduce(LCIteratorRef iterator, void* info, void *accumulator, LCReduceCb each);
+
+#endif
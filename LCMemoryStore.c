@@ -38,15 +38,12 @@ FILE* memoryStoreWrite(void *cookie, LCTypeRef type, char *key) {
 }
 
 void memoryStoreDelete(void *cookie, LCTypeRef type, char *key) {
-  LCStringRef hashObj = LCStringCreate(key);
+  LCStackString(hashObj, key);
   LCMutableDictionaryDeleteKey(memoryStoreData(cookie), hashObj);
-  objectRelease(hashObj);
 }
 
 FILE* memoryStoreRead(void *cookie, LCTypeRef type, char *key) {
-  LCStringRef hashObj = LCStringCreate(key);
-  LCMutableDataRef data = LCMutableDictionaryValueForKey(memoryStoreData(cookie), hashObj);
-  objectRelease(hashObj);
+  LCMutableDataRef data = LCMutableDictionaryValueForCString(memoryStoreData(cookie), key);
   if (data) {
     return createMemoryReadStream(NULL, LCMutableDataDataRef(data), LCMutableDataLength(data), false, NULL);
   } else {
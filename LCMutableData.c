@@ -78,7 +78,7 @@ LCByte* LCMutableDataDataRef(LCMutableDataRef data) {
 
 void LCMutableDataAppend(LCMutableDataRef object, LCByte data[], size_t length) {
   mutableDataRef dataStruct = objectData(object);
-  mutableDataEnsureLength(dataStruct, length);
+  mutableDataEnsureLength(dataStruct, dataStruct->length + length);
   memcpy(&(dataStruct->data[dataStruct->length]), data, length * sizeof(LCByte));
   dataStruct->length = dataStruct->length + length;
 }
@@ -1,10 +1,12 @@
 
 #include "LCMutableDictionary.h"
+#include "LCString.h"
 
 typedef struct mutableDictData* mutableDictDataRef;
 
 void mutableDictionaryDealloc(LCObjectRef object);
 void mutableDictionaryWalkChildren(LCObjectRef object, void *cookie, childCallback cb);
+void mutableDictionaryWalkReferences(LCObjectRef object, void *cookie, childCallback cb);
 void mutableDictionaryStoreChildren(LCObjectRef object, char *key, LCObjectRef objects[], size_t length);
 
 struct mutableDictData {
@@ -15,26 +17,33 @@ struct LCType typeMutableDictionary = {
   .name = "LCMutableDictionary",
   .immutable = false,
   .dealloc = mutableDictionaryDealloc,
+  .length = LCMutableDictionaryLength,
   .walkChildren = mutableDictionaryWalkChildren,
+  .walkReferences = mutableDictionaryWalkReferences,
   .storeChildren = mutableDictionaryStoreChildren
 };
 
 LCTypeRef LCTypeMutableDictionary = &typeMutableDictionary;
 
-LCMutableDictionaryRef LCMutableDictionaryCreate(LCKeyValueRef keyValues[], size_t length) {
+static LCMutableDictionaryRef mutableDictionaryCreateWithArray(LCMutableArrayRef keyValues) {
   mutableDictDataRef newDict = malloc(sizeof(struct mutableDictData));
   if (newDict) {
-    newDict->keyValues = LCMutableArrayCreate(keyValues, length);
+    newDict->keyValues = keyValues;
     return objectCreate(LCTypeMutableDictionary, newDict);
   } else {
+    objectRelease(keyValues);
     return NULL;
   }
+}
+
+LCMutableDictionaryRef LCMutableDictionaryCreate(LCKeyValueRef keyValues[], size_t length) {
+  return mutableDictionaryCreateWithArray(LCMutableArrayCreate(keyValues, length));
 };
 
 LCKeyValueRef LCMutableDictionaryEntryForKey(LCMutableDictionaryRef dict, LCObjectRef key) {
   LCKeyValueRef* keyValues = LCMutableDictionaryEntries(dict);
   for (LCInteger i=0; i<LCMutableDictionaryLength(dict); i++) {
-    if(objectCompare(key, LCKeyValueKey(keyValues[i])) == LCEqual) {
+    if(objectEqual(key, LCKeyValueKey(keyValues[i]))) {
       return keyValues[i];
     }
   }
@@ -50,12 +59,26 @@ LCObjectRef LCMutableDictionaryValueForKey(LCMutableDictionaryRef dict, LCObject
   }
 }
 
+LCKeyValueRef LCMutableDictionaryEntryForCString(LCMutableDictionaryRef dict, char *key) {
+  LCStackString(keyString, key);
+  return LCMutableDictionaryEntryForKey(dict, keyString);
+}
+
+LCObjectRef LCMutableDictionaryValueForCString(LCMutableDictionaryRef dict, char *key) {
+  LCStackString(keyString, key);
+  return LCMutableDictionaryValueForKey(dict, keyString);
+}
+
 void LCMutableDictionaryDeleteKey(LCMutableDictionaryRef dict, LCObjectRef key) {
-  LCKeyValueRef* keyValues = LCMutableDictionaryEntries(dict);
-  for (LCInteger i=0; i<LCMutableDictionaryLength(dict); i++) {
-    if(objectCompare(key, LCKeyValueKey(keyValues[i])) == LCEqual) {
-      mutableDictDataRef dictData = objectData(dict);
+  mutableDictDataRef dictData = objectData(dict);
+  LCInteger i = 0;
+  while (i<LCMutableDictionaryLength(dict)) {
+    // removing may copy the shared entries buffer, so the entries are fetched again every time
+    LCKeyValueRef* keyValues = LCMutableDictionaryEntries(dict);
+    if(objectEqual(key, LCKeyValueKey(keyValues[i]))) {
       LCMutableArrayRemoveIndex(dictData->keyValues, i);
+    } else {
+      i++;
     }
   }
 }
@@ -65,6 +88,7 @@ void LCMutableDictionarySetValueForKey(LCMutableDictionaryRef dict, LCObjectRef
   LCKeyValueRef keyValue = LCKeyValueCreate(key, value);
   mutableDictDataRef dictData = objectData(dict);
   LCMutableArrayAddObject(dictData->keyValues, keyValue);
+  objectRelease(keyValue);
 }
 
 void LCMutableDictionaryAddEntry(LCMutableDictionaryRef dict, LCKeyValueRef keyValue) {
@@ -75,17 +99,113 @@ void LCMutableDictionaryAddEntry(LCMutableDictionaryRef dict, LCKeyValueRef keyV
   }
 }
 
+struct entryRef {
+  LCObjectRef key;
+  LCInteger index;
+};
+
+// keys are equal exactly when objectEqual finds them equal, the single lookups match keys with it
+static int keyOrder(LCObjectRef key1, LCObjectRef key2) {
+  LCCompare result = objectCompare(key1, key2);
+  if (result == LCEqual) {
+    return 0;
+  }
+  return result == LCGreater ? 1 : -1;
+}
+
+static int entryKeyCompare(const void *elem1, const void *elem2) {
+  const struct entryRef *entry1 = elem1;
+  const struct entryRef *entry2 = elem2;
+  int result = keyOrder(entry1->key, entry2->key);
+  if (result == 0) {
+    return entry1->index - entry2->index;
+  }
+  return result;
+}
+
+static int entryIndexCompare(const void *elem1, const void *elem2) {
+  return ((const struct entryRef*)elem1)->index - ((const struct entryRef*)elem2)->index;
+}
+
+/*
+ same result as calling LCMutableDictionaryAddEntry for every entry: the new entries are sorted by key so
+ existing entries are matched with a binary search, replaced entries are removed in one pass and the new
+ entries are appended with one resize, the last entry wins when a key is given more than once
+*/
 void LCMutableDictionaryAddEntries(LCMutableDictionaryRef dict, LCKeyValueRef keyValues[], size_t length) {
+  if (length == 0) {
+    return;
+  }
+  mutableDictDataRef dictData = objectData(dict);
+  size_t existingLength = LCMutableDictionaryLength(dict);
+  struct entryRef *entries = malloc(sizeof(struct entryRef) * length);
+  LCInteger *removed = malloc(sizeof(LCInteger) * (existingLength ? existingLength : 1));
+  LCKeyValueRef *added = malloc(sizeof(LCKeyValueRef) * length);
+  if (!entries || !removed || !added) {
+    perror("LCMutableDictionaryAddEntries");
+    lcFree(entries);
+    lcFree(removed);
+    lcFree(added);
+    return;
+  }
+  for (LCInteger i=0; i<length; i++) {
+    entries[i].key = LCKeyValueKey(keyValues[i]);
+    entries[i].index = i;
+  }
+  qsort(entries, length, sizeof(struct entryRef), entryKeyCompare);
+  size_t uniqueLength = 0;
   for (LCInteger i=0; i<length; i++) {
-    LCMutableDictionaryAddEntry(dict, keyValues[i]);
+    if (i+1 < length && keyOrder(entries[i].key, entries[i+1].key) == 0) {
+      continue;
+    }
+    entries[uniqueLength] = entries[i];
+    uniqueLength++;
   }
+  
+  LCKeyValueRef* existing = LCMutableDictionaryEntries(dict);
+  size_t removedLength = 0;
+  for (LCInteger i=0; i<existingLength; i++) {
+    LCObjectRef key = LCKeyValueKey(existing[i]);
+    size_t low = 0, high = uniqueLength;
+    while (low < high) {
+      size_t middle = (low + high) / 2;
+      if (keyOrder(entries[middle].key, key) < 0) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    if (low < uniqueLength && keyOrder(entries[low].key, key) == 0) {
+      removed[removedLength] = i;
+      removedLength++;
+    }
+  }
+  LCMutableArrayRemoveIndices(dictData->keyValues, removed, removedLength);
+  
+  qsort(entries, uniqueLength, sizeof(struct entryRef), entryIndexCompare);
+  size_t addedLength = 0;
+  for (LCInteger i=0; i<uniqueLength; i++) {
+    if (LCKeyValueValue(keyValues[entries[i].index]) != NULL) {
+      added[addedLength] = keyValues[entries[i].index];
+      addedLength++;
+    }
+  }
+  LCMutableArrayAddObjects(dictData->keyValues, added, addedLength);
+  lcFree(added);
+  lcFree(removed);
+  lcFree(entries);
 }
 
 LCMutableDictionaryRef LCMutableDictionaryCopy(LCMutableDictionaryRef dict) {
-  return LCMutableDictionaryCreate(LCMutableDictionaryEntries(dict), LCMutableDictionaryLength(dict));
+  mutableDictDataRef dictData = objectData(dict);
+  return mutableDictionaryCreateWithArray(LCMutableArrayCopy(dictData->keyValues));
 }
 
 size_t LCMutableDictionaryLength(LCMutableDictionaryRef dict) {
+  uint64_t length;
+  if (objectStubMeta(dict, LCMetaLength, &length)) {
+    return length;
+  }
   mutableDictDataRef dictData = objectData(dict);
   return LCMutableArrayLength(dictData->keyValues);
 }
@@ -104,7 +224,7 @@ LCMutableArrayRef LCMutableDictionaryCreateChangesArray(LCMutableDictionaryRef o
     LCObjectRef key = LCKeyValueKey(originalKeyValues[i]);
     LCObjectRef value = LCKeyValueValue(originalKeyValues[i]);
     LCObjectRef newValue = LCMutableDictionaryValueForKey(new, key);
-    if (objectCompare(value, newValue) != LCEqual) {
+    if (!objectEqual(value, newValue)) {
       LCMutableDictionarySetValueForKey(changes, key, newValue);
     }
   }
@@ -112,7 +232,7 @@ LCMutableArrayRef LCMutableDictionaryCreateChangesArray(LCMutableDictionaryRef o
     LCObjectRef key = LCKeyValueKey(newKeyValues[i]);
     LCObjectRef newValue = LCKeyValueValue(newKeyValues[i]);
     LCObjectRef originalValue = LCMutableDictionaryValueForKey(original, key);
-    if (objectCompare(originalValue, newValue) != LCEqual) {
+    if (!objectEqual(originalValue, newValue)) {
       LCMutableDictionarySetValueForKey(changes, key, newValue);
     }
   }
@@ -143,7 +263,7 @@ LCMutableArrayRef LCMutableDictionaryCreateUpdatedArray(LCMutableDictionaryRef o
     void* value = LCKeyValueValue(originalKeyValues[i]);
     LCKeyValueRef newEntry = LCMutableDictionaryEntryForKey(new, key);
     void* newValue = LCKeyValueValue(newEntry);
-    if ((objectCompare(value, newValue) != LCEqual) && (newValue != NULL)) {
+    if (!objectEqual(value, newValue) && (newValue != NULL)) {
       LCMutableArrayAddObject(changes, newEntry);
     }
   }
@@ -174,6 +294,11 @@ void mutableDictionaryWalkChildren(LCObjectRef object, void *cookie, childCallba
   cb(cookie, "entries", LCMutableDictionaryEntries(object), LCMutableDictionaryLength(object), false);
 }
 
+void mutableDictionaryWalkReferences(LCObjectRef object, void *cookie, childCallback cb) {
+  mutableDictDataRef data = objectData(object);
+  cb(cookie, "keyValues", &data->keyValues, 1, false);
+}
+
 void mutableDictionaryStoreChildren(LCObjectRef object, char *key, LCObjectRef objects[], size_t length) {
   if (strcmp(key, "entries")==0) {
     mutableDictDataRef data = objectData(object);
@@ -12,6 +12,8 @@ extern LCTypeRef LCTypeMutableDictionary;
 LCMutableDictionaryRef LCMutableDictionaryCreate(LCKeyValueRef keyValues[], size_t length);
 LCKeyValueRef LCMutableDictionaryEntryForKey(LCMutableDictionaryRef dict, LCObjectRef key);
 LCObjectRef LCMutableDictionaryValueForKey(LCMutableDictionaryRef dict, LCObjectRef key);
+LCKeyValueRef LCMutableDictionaryEntryForCString(LCMutableDictionaryRef dict, char *key);
+LCObjectRef LCMutableDictionaryValueForCString(LCMutableDictionaryRef dict, char *key);
 void LCMutableDictionarySetValueForKey(LCMutableDictionaryRef dict, LCObjectRef key, LCObjectRef value);
 void LCMutableDictionaryDeleteKey(LCMutableDictionaryRef dict, LCObjectRef key);
 void LCMutableDictionaryAddEntry(LCMutableDictionaryRef dict, LCKeyValueRef keyValue);
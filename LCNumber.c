@@ -0,0 +1,213 @@
+
+#include "LCNumber.h"
+#include "LCSHA.h"
+#include "LCUtils.h"
+
+#define NUMBER_ENCODED_MAX_LENGTH 11
+#define NUMBER_TAG_INTEGER 'i'
+#define NUMBER_TAG_DOUBLE 'd'
+
+typedef struct numberData* numberDataRef;
+
+LCCompare numberCompare(LCObjectRef object1, LCObjectRef object2);
+uint64_t numberSortKey(LCObjectRef object, LCInteger level);
+void numberSerialize(LCObjectRef object, FILE *fd);
+void* numberDeserialize(LCObjectRef object, FILE *fd);
+void numberHash(LCObjectRef object, char hashBuffer[HASH_LENGTH]);
+
+struct numberData {
+  bool isDouble;
+  union {
+    int64_t integer;
+    double real;
+  } value;
+};
+
+struct LCType numberType = {
+  .name = "LCNumber",
+  .immutable = true,
+  .serializationFormat = LCBinary,
+  .compare = numberCompare,
+  .sortKey = numberSortKey,
+  .serializeData = numberSerialize,
+  .deserializeData = numberDeserialize,
+  .hash = numberHash
+};
+
+LCTypeRef LCTypeNumber = &numberType;
+
+static numberDataRef numberCreateStruct() {
+  numberDataRef newNumber = malloc(sizeof(struct numberData));
+  if (newNumber) {
+    newNumber->isDouble = false;
+    newNumber->value.integer = 0;
+  }
+  return newNumber;
+}
+
+LCNumberRef LCNumberCreateInteger(int64_t value) {
+  if (value >= LC_TAGGED_INTEGER_MIN && value <= LC_TAGGED_INTEGER_MAX) {
+    return objectCreateTaggedInteger(value);
+  }
+  numberDataRef number = numberCreateStruct();
+  if (number) {
+    number->value.integer = value;
+    return objectCreate(LCTypeNumber, number);
+  }
+  return NULL;
+}
+
+LCNumberRef LCNumberCreateDouble(double value) {
+  numberDataRef number = numberCreateStruct();
+  if (number) {
+    number->isDouble = true;
+    number->value.real = value;
+    return objectCreate(LCTypeNumber, number);
+  }
+  return NULL;
+}
+
+LCNumberRef LCNumberCreateFromHash(LCContextRef context, char hash[HASH_LENGTH]) {
+  return objectCreateFromContext(context, LCTypeNumber, hash);
+}
+
+bool LCNumberIsDouble(LCNumberRef number) {
+  if (objectIsTaggedInteger(number)) {
+    return false;
+  }
+  numberDataRef data = objectData(number);
+  return data->isDouble;
+}
+
+int64_t LCNumberInteger(LCNumberRef number) {
+  if (objectIsTaggedInteger(number)) {
+    return objectTaggedIntegerValue(number);
+  }
+  numberDataRef data = objectData(number);
+  if (data->isDouble) {
+    return (int64_t)data->value.real;
+  }
+  return data->value.integer;
+}
+
+double LCNumberDouble(LCNumberRef number) {
+  if (objectIsTaggedInteger(number)) {
+    return (double)objectTaggedIntegerValue(number);
+  }
+  numberDataRef data = objectData(number);
+  if (data->isDouble) {
+    return data->value.real;
+  }
+  return (double)data->value.integer;
+}
+
+LCCompare numberCompare(LCObjectRef object1, LCObjectRef object2) {
+  bool isDouble1 = LCNumberIsDouble(object1);
+  bool isDouble2 = LCNumberIsDouble(object2);
+  if (isDouble1 && isDouble2) {
+    return compareDoubles(LCNumberDouble(object1), LCNumberDouble(object2));
+  }
+  if (isDouble1) {
+    LCCompare result = compareIntegerToDouble(LCNumberInteger(object2), LCNumberDouble(object1));
+    return result == LCEqual ? LCEqual : (result == LCGreater ? LCSmaller : LCGreater);
+  }
+  if (isDouble2) {
+    return compareIntegerToDouble(LCNumberInteger(object1), LCNumberDouble(object2));
+  }
+  int64_t integer1 = LCNumberInteger(object1);
+  int64_t integer2 = LCNumberInteger(object2);
+  if (integer1 == integer2) {
+    return LCEqual;
+  }
+  return integer1 > integer2 ? LCGreater : LCSmaller;
+}
+
+/*
+ the bits of the number as a double with the sign bit flipped for positive and all bits flipped for
+ negative numbers, so the keys order like the numbers; integers too large for a double round to a
+ neighbouring key and are told apart by numberCompare, every NaN gets the key of the positive quiet
+ NaN, above the key of infinity; numbers have a single key level
+*/
+uint64_t numberSortKey(LCObjectRef object, LCInteger level) {
+  if (level > 0) {
+    return 0;
+  }
+  double real = LCNumberIsDouble(object) ? LCNumberDouble(object) : (double)LCNumberInteger(object);
+  if (real == 0) {
+    real = 0;
+  } else if (isnan(real)) {
+    real = NAN;
+  }
+  uint64_t bits;
+  memcpy(&bits, &real, sizeof(bits));
+  if (bits & ((uint64_t)1 << 63)) {
+    return ~bits;
+  }
+  return bits | ((uint64_t)1 << 63);
+}
+
+/*
+ integers are written as a tag byte followed by a zigzag varint,
+ doubles as a tag byte followed by their 8 bytes in little endian order
+*/
+static size_t numberEncode(LCNumberRef number, LCByte buffer[NUMBER_ENCODED_MAX_LENGTH]) {
+  if (LCNumberIsDouble(number)) {
+    double real = LCNumberDouble(number);
+    uint64_t bits;
+    memcpy(&bits, &real, sizeof(bits));
+    buffer[0] = NUMBER_TAG_DOUBLE;
+    for (LCInteger i=0; i<8; i++) {
+      buffer[i+1] = (LCByte)(bits >> (i*8));
+    }
+    return 9;
+  }
+  int64_t integer = LCNumberInteger(number);
+  uint64_t zigzag = ((uint64_t)integer << 1) ^ (uint64_t)(integer >> 63);
+  size_t length = 0;
+  buffer[length++] = NUMBER_TAG_INTEGER;
+  while (zigzag >= 0x80) {
+    buffer[length++] = (LCByte)(zigzag | 0x80);
+    zigzag = zigzag >> 7;
+  }
+  buffer[length++] = (LCByte)zigzag;
+  return length;
+}
+
+void numberSerialize(LCObjectRef object, FILE *fd) {
+  LCByte buffer[NUMBER_ENCODED_MAX_LENGTH];
+  size_t length = numberEncode(object, buffer);
+  fwrite(buffer, sizeof(LCByte), length, fd);
+}
+
+void* numberDeserialize(LCObjectRef object, FILE *fd) {
+  LCByte buffer[NUMBER_ENCODED_MAX_LENGTH];
+  size_t length = fread(buffer, sizeof(LCByte), NUMBER_ENCODED_MAX_LENGTH, fd);
+  numberDataRef number = numberCreateStruct();
+  if (!number || length == 0) {
+    return number;
+  }
+  if (buffer[0] == NUMBER_TAG_DOUBLE) {
+    uint64_t bits = 0;
+    for (LCInteger i=0; i<8 && i+1<length; i++) {
+      bits = bits | ((uint64_t)buffer[i+1] << (i*8));
+    }
+    number->isDouble = true;
+    memcpy(&(number->value.real), &bits, sizeof(bits));
+  } else {
+    uint64_t zigzag = 0;
+    for (LCInteger i=1; i<length; i++) {
+      zigzag = zigzag | ((uint64_t)(buffer[i] & 0x7f) << ((i-1)*7));
+      if (!(buffer[i] & 0x80)) {
+        break;
+      }
+    }
+    number->value.integer = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+  }
+  return number;
+}
+
+void numberHash(LCObjectRef object, char hashBuffer[HASH_LENGTH]) {
+  LCByte buffer[NUMBER_ENCODED_MAX_LENGTH];
+  size_t length = numberEncode(object, buffer);
+  createSHAString(buffer, length, hashBuffer);
+}
@@ -9,6 +9,16 @@
 #ifndef LivelyC_LCNumber_h
 #define LivelyC_LCNumber_h
 
+#include "LCCore.h"
 
+typedef LCObjectRef LCNumberRef;
+extern LCTypeRef LCTypeNumber;
+
+LCNumberRef LCNumberCreateInteger(int64_t value);
+LCNumberRef LCNumberCreateDouble(double value);
+LCNumberRef LCNumberCreateFromHash(LCContextRef context, char hash[HASH_LENGTH]);
+bool LCNumberIsDouble(LCNumberRef number);
+int64_t LCNumberInteger(LCNumberRef number);
+double LCNumberDouble(LCNumberRef number);
 
 #endif
@@ -0,0 +1,326 @@
+
+#include "LCRecordBatch.h"
+#include "LCMutableDictionary.h"
+#include "LCNumber.h"
+#include "LCString.h"
+
+typedef struct recordBatchData* recordBatchDataRef;
+
+void recordBatchDealloc(LCObjectRef object);
+void recordBatchWalkChildren(LCObjectRef object, void *cookie, childCallback cb);
+void recordBatchWalkReferences(LCObjectRef object, void *cookie, childCallback cb);
+void recordBatchStoreChildren(LCObjectRef object, char *key, LCObjectRef objects[], size_t length);
+static void* recordBatchInitData();
+
+/*
+ - every column is an LCTypedArray: int64 for integer columns, double for double columns and
+   int32 dictionary codes for string columns
+ - dictionaries holds one LCArray of distinct strings per column, empty for numeric columns
+ - a column with any string value is a string column, missing values and values of other types
+   are stored as code -1; numeric columns with missing or non integer values become double
+   columns with NAN for rows that are missing or hold something other than an LCNumber
+*/
+struct recordBatchData {
+  LCArrayRef fields;
+  LCArrayRef columns;
+  LCArrayRef dictionaries;
+};
+
+struct LCType typeRecordBatch = {
+  .name = "LCRecordBatch",
+  .immutable = true,
+  .serializationFormat = LCText,
+  .dealloc = recordBatchDealloc,
+  .initData = recordBatchInitData,
+  .walkChildren = recordBatchWalkChildren,
+  .walkReferences = recordBatchWalkReferences,
+  .storeChildren = recordBatchStoreChildren
+};
+
+LCTypeRef LCTypeRecordBatch = &typeRecordBatch;
+
+static void* recordBatchInitData() {
+  recordBatchDataRef data = malloc(sizeof(struct recordBatchData));
+  if (data) {
+    data->fields = NULL;
+    data->columns = NULL;
+    data->dictionaries = NULL;
+  }
+  return data;
+}
+
+// leaves column and dictionary NULL when the buffers can't be allocated
+static void recordBatchEncodeStrings(LCObjectRef values[], size_t length, LCTypedArrayRef *column,
+                                     LCArrayRef *dictionary) {
+  size_t slotsLength = 16;
+  while (slotsLength < length * 2) {
+    slotsLength = slotsLength * 2;
+  }
+  int32_t *codes = malloc(sizeof(int32_t) * (length ? length : 1));
+  int32_t *slots = malloc(sizeof(int32_t) * slotsLength);
+  if (!codes || !slots) {
+    perror("recordBatchEncodeStrings");
+    lcFree(codes);
+    lcFree(slots);
+    *column = NULL;
+    *dictionary = NULL;
+    return;
+  }
+  for (size_t i=0; i<slotsLength; i++) {
+    slots[i] = -1;
+  }
+  LCMutableArrayRef strings = LCMutableArrayCreate(NULL, 0);
+  for (size_t i=0; i<length; i++) {
+    if (!values[i] || objectType(values[i]) != LCTypeString) {
+      codes[i] = -1;
+      continue;
+    }
+    size_t slot = LCStringHashValue(values[i]) & (slotsLength - 1);
+    while (slots[slot] != -1 && !LCStringEqual(LCMutableArrayObjectAtIndex(strings, slots[slot]), values[i])) {
+      slot = (slot + 1) & (slotsLength - 1);
+    }
+    if (slots[slot] == -1) {
+      slots[slot] = (int32_t)LCMutableArrayLength(strings);
+      LCMutableArrayAddObject(strings, values[i]);
+    }
+    codes[i] = slots[slot];
+  }
+  *column = LCTypedArrayCreate(LCElementInt32, codes, length);
+  *dictionary = LCMutableArrayCreateArray(strings);
+  objectRelease(strings);
+  lcFree(slots);
+  lcFree(codes);
+}
+
+static LCTypedArrayRef recordBatchEncodeNumbers(LCObjectRef values[], size_t length) {
+  bool integers = true;
+  for (size_t i=0; i<length && integers; i++) {
+    integers = values[i] && objectType(values[i]) == LCTypeNumber && !LCNumberIsDouble(values[i]);
+  }
+  if (integers) {
+    int64_t *column = malloc(sizeof(int64_t) * (length ? length : 1));
+    if (!column) {
+      perror("recordBatchEncodeNumbers");
+      return NULL;
+    }
+    for (size_t i=0; i<length; i++) {
+      column[i] = LCNumberInteger(values[i]);
+    }
+    LCTypedArrayRef array = LCTypedArrayCreate(LCElementInt64, column, length);
+    lcFree(column);
+    return array;
+  }
+  double *column = malloc(sizeof(double) * (length ? length : 1));
+  if (!column) {
+    perror("recordBatchEncodeNumbers");
+    return NULL;
+  }
+  for (size_t i=0; i<length; i++) {
+    if (values[i] && objectType(values[i]) == LCTypeNumber) {
+      column[i] = LCNumberDouble(values[i]);
+    } else {
+      column[i] = NAN;
+    }
+  }
+  LCTypedArrayRef array = LCTypedArrayCreate(LCElementDouble, column, length);
+  lcFree(column);
+  return array;
+}
+
+// every row must be an LCMutableDictionary, cells that don't match their column are coerced as above
+LCRecordBatchRef LCRecordBatchCreateFromDictionaries(LCArrayRef dictionaries, LCStringRef fields[], size_t length) {
+  size_t rows = LCArrayLength(dictionaries);
+  LCObjectRef *dicts = LCArrayObjects(dictionaries);
+  for (size_t i=0; i<rows; i++) {
+    if (!dicts[i] || objectType(dicts[i]) != LCTypeMutableDictionary) {
+      perror(ErrorRecordBatchRow);
+      return NULL;
+    }
+  }
+  LCObjectRef *values = malloc(sizeof(LCObjectRef) * (rows ? rows : 1));
+  recordBatchDataRef data = recordBatchInitData();
+  if (!values || !data) {
+    perror("LCRecordBatchCreateFromDictionaries");
+    lcFree(values);
+    lcFree(data);
+    return NULL;
+  }
+  LCTypedArrayRef columns[length];
+  LCArrayRef columnDictionaries[length];
+  for (LCInteger f=0; f<length; f++) {
+    bool strings = false;
+    for (size_t i=0; i<rows; i++) {
+      values[i] = LCMutableDictionaryValueForKey(dicts[i], fields[f]);
+      strings = strings || (values[i] && objectType(values[i]) == LCTypeString);
+    }
+    if (strings) {
+      recordBatchEncodeStrings(values, rows, &columns[f], &columnDictionaries[f]);
+    } else {
+      columns[f] = recordBatchEncodeNumbers(values, rows);
+      columnDictionaries[f] = LCArrayCreate(NULL, 0);
+    }
+    if (!columns[f] || !columnDictionaries[f]) {
+      for (LCInteger i=0; i<=f; i++) {
+        objectRelease(columns[i]);
+        objectRelease(columnDictionaries[i]);
+      }
+      lcFree(values);
+      lcFree(data);
+      return NULL;
+    }
+  }
+  lcFree(values);
+  data->fields = LCArrayCreate(fields, length);
+  data->columns = LCArrayCreate(columns, length);
+  data->dictionaries = LCArrayCreate(columnDictionaries, length);
+  for (LCInteger f=0; f<length; f++) {
+    objectRelease(columns[f]);
+    objectRelease(columnDictionaries[f]);
+  }
+  return objectCreate(LCTypeRecordBatch, data);
+}
+
+LCRecordBatchRef LCRecordBatchCreateFromHash(LCContextRef context, char hash[HASH_LENGTH]) {
+  return objectCreateFromContext(context, LCTypeRecordBatch, hash);
+}
+
+static LCTypedArrayRef recordBatchColumn(LCRecordBatchRef batch, LCInteger column) {
+  recordBatchDataRef data = objectData(batch);
+  return LCArrayObjectAtIndex(data->columns, column);
+}
+
+size_t LCRecordBatchLength(LCRecordBatchRef batch) {
+  if (LCRecordBatchColumnCount(batch) == 0) {
+    return 0;
+  }
+  return LCTypedArrayLength(recordBatchColumn(batch, 0));
+}
+
+size_t LCRecordBatchColumnCount(LCRecordBatchRef batch) {
+  recordBatchDataRef data = objectData(batch);
+  return LCArrayLength(data->columns);
+}
+
+LCInteger LCRecordBatchColumnIndex(LCRecordBatchRef batch, LCStringRef field) {
+  recordBatchDataRef data = objectData(batch);
+  LCStringRef *fields = LCArrayObjects(data->fields);
+  for (LCInteger i=0; i<LCArrayLength(data->fields); i++) {
+    if (objectCompare(fields[i], field) == LCEqual) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+LCColumnType LCRecordBatchColumnType(LCRecordBatchRef batch, LCInteger column) {
+  switch (LCTypedArrayElementType(recordBatchColumn(batch, column))) {
+    case LCElementInt32:
+      return LCColumnString;
+    case LCElementInt64:
+      return LCColumnInteger;
+    default:
+      return LCColumnDouble;
+  }
+}
+
+int64_t* LCRecordBatchIntegerColumn(LCRecordBatchRef batch, LCInteger column) {
+  if (LCRecordBatchColumnType(batch, column) != LCColumnInteger) {
+    return NULL;
+  }
+  return LCTypedArrayValues(recordBatchColumn(batch, column));
+}
+
+double* LCRecordBatchDoubleColumn(LCRecordBatchRef batch, LCInteger column) {
+  if (LCRecordBatchColumnType(batch, column) != LCColumnDouble) {
+    return NULL;
+  }
+  return LCTypedArrayValues(recordBatchColumn(batch, column));
+}
+
+int32_t* LCRecordBatchStringCodes(LCRecordBatchRef batch, LCInteger column) {
+  if (LCRecordBatchColumnType(batch, column) != LCColumnString) {
+    return NULL;
+  }
+  return LCTypedArrayValues(recordBatchColumn(batch, column));
+}
+
+LCArrayRef LCRecordBatchStringDictionary(LCRecordBatchRef batch, LCInteger column) {
+  recordBatchDataRef data = objectData(batch);
+  return LCArrayObjectAtIndex(data->dictionaries, column);
+}
+
+// rows must have room for LCRecordBatchLength(batch) indices
+size_t LCRecordBatchFilterRange(LCRecordBatchRef batch, LCInteger column, double min, double max, size_t rows[]) {
+  size_t length = LCRecordBatchLength(batch);
+  size_t found = 0;
+  if (LCRecordBatchColumnType(batch, column) == LCColumnInteger) {
+    int64_t *values = LCRecordBatchIntegerColumn(batch, column);
+    for (size_t i=0; i<length; i++) {
+      rows[found] = i;
+      found = found + (values[i] >= min && values[i] <= max);
+    }
+  } else if (LCRecordBatchColumnType(batch, column) == LCColumnDouble) {
+    double *values = LCRecordBatchDoubleColumn(batch, column);
+    for (size_t i=0; i<length; i++) {
+      rows[found] = i;
+      found = found + (values[i] >= min && values[i] <= max);
+    }
+  }
+  return found;
+}
+
+size_t LCRecordBatchFilterString(LCRecordBatchRef batch, LCInteger column, LCStringRef value, size_t rows[]) {
+  int32_t *codes = LCRecordBatchStringCodes(batch, column);
+  if (!codes) {
+    return 0;
+  }
+  LCArrayRef dictionary = LCRecordBatchStringDictionary(batch, column);
+  int32_t code = -1;
+  for (LCInteger i=0; i<LCArrayLength(dictionary) && code == -1; i++) {
+    if (objectCompare(LCArrayObjectAtIndex(dictionary, i), value) == LCEqual) {
+      code = i;
+    }
+  }
+  if (code == -1) {
+    return 0;
+  }
+  size_t length = LCRecordBatchLength(batch);
+  size_t found = 0;
+  for (size_t i=0; i<length; i++) {
+    rows[found] = i;
+    found = found + (codes[i] == code);
+  }
+  return found;
+}
+
+void recordBatchDealloc(LCObjectRef object) {
+  recordBatchDataRef data = objectData(object);
+  objectRelease(data->fields);
+  objectRelease(data->columns);
+  objectRelease(data->dictionaries);
+  lcFree(data);
+}
+
+void recordBatchWalkChildren(LCObjectRef object, void *cookie, childCallback cb) {
+  recordBatchDataRef data = objectData(object);
+  cb(cookie, "fields", LCArrayObjects(data->fields), LCArrayLength(data->fields), false);
+  cb(cookie, "columns", LCArrayObjects(data->columns), LCArrayLength(data->columns), false);
+  cb(cookie, "dictionaries", LCArrayObjects(data->dictionaries), LCArrayLength(data->dictionaries), false);
+}
+
+void recordBatchWalkReferences(LCObjectRef object, void *cookie, childCallback cb) {
+  recordBatchDataRef data = objectData(object);
+  LCObjectRef arrays[] = {data->fields, data->columns, data->dictionaries};
+  cb(cookie, "arrays", arrays, 3, false);
+}
+
+void recordBatchStoreChildren(LCObjectRef object, char *key, LCObjectRef objects[], size_t length) {
+  recordBatchDataRef data = objectData(object);
+  if (strcmp(key, "fields")==0) {
+    data->fields = LCArrayCreate(objects, length);
+  } else if (strcmp(key, "columns")==0) {
+    data->columns = LCArrayCreate(objects, length);
+  } else if (strcmp(key, "dictionaries")==0) {
+    data->dictionaries = LCArrayCreate(objects, length);
+  }
+}
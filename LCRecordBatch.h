@@ -0,0 +1,31 @@
+
+#ifndef LivelyC_LCRecordBatch_h
+#define LivelyC_LCRecordBatch_h
+
+#include "LCCore.h"
+#include "LCArray.h"
+#include "LCTypedArray.h"
+
+typedef enum {
+  LCColumnInteger,
+  LCColumnDouble,
+  LCColumnString
+} LCColumnType;
+
+typedef LCObjectRef LCRecordBatchRef;
+extern LCTypeRef LCTypeRecordBatch;
+
+LCRecordBatchRef LCRecordBatchCreateFromDictionaries(LCArrayRef dictionaries, LCStringRef fields[], size_t length);
+LCRecordBatchRef LCRecordBatchCreateFromHash(LCContextRef context, char hash[HASH_LENGTH]);
+size_t LCRecordBatchLength(LCRecordBatchRef batch);
+size_t LCRecordBatchColumnCount(LCRecordBatchRef batch);
+LCInteger LCRecordBatchColumnIndex(LCRecordBatchRef batch, LCStringRef field);
+LCColumnType LCRecordBatchColumnType(LCRecordBatchRef batch, LCInteger column);
+int64_t* LCRecordBatchIntegerColumn(LCRecordBatchRef batch, LCInteger column);
+double* LCRecordBatchDoubleColumn(LCRecordBatchRef batch, LCInteger column);
+int32_t* LCRecordBatchStringCodes(LCRecordBatchRef batch, LCInteger column);
+LCArrayRef LCRecordBatchStringDictionary(LCRecordBatchRef batch, LCInteger column);
+size_t LCRecordBatchFilterRange(LCRecordBatchRef batch, LCInteger column, double min, double max, size_t rows[]);
+size_t LCRecordBatchFilterString(LCRecordBatchRef batch, LCInteger column, LCStringRef value, size_t rows[]);
+
+#endif
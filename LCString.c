@@ -5,29 +5,106 @@
 #include "LCMemoryStream.h"
 
 LCCompare stringCompare(LCStringRef object1, LCStringRef object2);
+uint64_t stringSortKey(LCObjectRef object, LCInteger level);
 void stringSerialize(LCObjectRef object, FILE *fd);
 void* stringDeserialize(LCObjectRef object, FILE* fd);
+void stringDealloc(LCObjectRef object);
+size_t stringDataSize(LCObjectRef object);
+void* mutableStringDeserialize(LCObjectRef object, FILE* fd);
+void mutableStringDealloc(LCObjectRef object);
 
+typedef struct stringData* stringDataRef;
+
+/*
+ - string is the buffer being built, it is grown with realloc and always NUL terminated;
+   LCMutableStringCreateString hands it to the new LCString and starts an empty one
+*/
+struct mutableStringData {
+  size_t capacity;
+  stringDataRef string;
+};
+
+typedef struct mutableStringData* mutableStringDataRef;
 
 struct LCType stringType = {
   .name = "LCString",
   .immutable = true,
+  .canonical = true,
   .serializationFormat = LCText,
+  .dealloc = stringDealloc,
   .compare = stringCompare,
+  .equal = LCStringEqual,
+  .sortKey = stringSortKey,
+  .dataSize = stringDataSize,
+  .length = LCStringLength,
   .serializeData = stringSerialize,
   .deserializeData = stringDeserialize
 };
 
+struct LCType mutableStringType = {
+  .name = "LCMutableString",
+  .immutable = false,
+  .serializationFormat = LCText,
+  .dealloc = mutableStringDealloc,
+  .compare = stringCompare,
+  .sortKey = stringSortKey,
+  .length = LCMutableStringLength,
+  .serializeData = stringSerialize,
+  .deserializeData = mutableStringDeserialize
+};
+
 LCTypeRef LCTypeString = &stringType;
+LCTypeRef LCTypeMutableString = &mutableStringType;
 
-LCStringRef LCStringCreate(char *string) {
-  char* stringData = malloc(strlen(string)+1);
-  if (stringData) {
-    strcpy(stringData, string);
-    LCStringRef stringObject = objectCreate(LCTypeString, stringData);
-    return stringObject;
+static stringDataRef stringDataOf(LCObjectRef string) {
+  if (objectType(string) == LCTypeMutableString) {
+    mutableStringDataRef data = objectData(string);
+    return data->string;
   }
-  return NULL;
+  return objectData(string);
+}
+
+static stringDataRef stringCreateData(size_t length) {
+  stringDataRef data = malloc(sizeof(struct stringData) + length + 1);
+  if (data) {
+    data->length = length;
+    data->hashValue = 0;
+    data->chars = data->buffer;
+    data->parent = NULL;
+    data->cString = NULL;
+    data->interned = false;
+    data->buffer[length] = '\0';
+  }
+  return data;
+}
+
+static LCStringRef stringCreateFromBuffers(char* buffers[], size_t lengths[], size_t length, char *delimiter) {
+  size_t delimiterLength = delimiter ? strlen(delimiter) : 0;
+  size_t totalLength = 0;
+  for (LCInteger i=0; i<length; i++) {
+    totalLength = totalLength + lengths[i];
+  }
+  if (length > 0) {
+    totalLength = totalLength + (length-1)*delimiterLength;
+  }
+  stringDataRef data = stringCreateData(totalLength);
+  if (!data) {
+    return NULL;
+  }
+  char *position = data->buffer;
+  for (LCInteger i=0; i<length; i++) {
+    if (i>0 && delimiterLength > 0) {
+      memcpy(position, delimiter, delimiterLength);
+      position = position + delimiterLength;
+    }
+    memcpy(position, buffers[i], lengths[i]);
+    position = position + lengths[i];
+  }
+  return objectCreate(LCTypeString, data);
+}
+
+LCStringRef LCStringCreate(char *string) {
+  return LCStringCreateFromChars(string, strlen(string));
 }
 
 LCStringRef LCStringCreateFromHash(LCContextRef context, char hash[HASH_LENGTH]) {
@@ -35,18 +112,32 @@ LCStringRef LCStringCreateFromHash(LCContextRef context, char hash[HASH_LENGTH])
 }
 
 LCStringRef LCStringCreateFromChars(char* characters, size_t length) {
-  char string[length+1];
-  string[length] = '\0';
-  memcpy(string, characters, length*sizeof(char));
-  return LCStringCreate(string);
+  stringDataRef data = stringCreateData(length);
+  if (data) {
+    memcpy(data->buffer, characters, length*sizeof(char));
+    return objectCreate(LCTypeString, data);
+  }
+  return NULL;
 }
 
 LCStringRef LCStringCreateFromStringsWithDelim(LCStringRef strings[], size_t length, char *delimiter) {
-  char *stringArray[length];
+  char **buffers = malloc(sizeof(char*) * (length ? length : 1));
+  size_t *lengths = malloc(sizeof(size_t) * (length ? length : 1));
+  if (!buffers || !lengths) {
+    perror("LCStringCreateFromStringsWithDelim");
+    lcFree(buffers);
+    lcFree(lengths);
+    return NULL;
+  }
   for (LCInteger i=0; i<length; i++) {
-    stringArray[i] = LCStringChars(strings[i]);
+    stringDataRef data = stringDataOf(strings[i]);
+    buffers[i] = data->chars;
+    lengths[i] = data->length;
   }
-  return LCStringCreateFromStringArrayWithDelim(stringArray, length, delimiter);
+  LCStringRef string = stringCreateFromBuffers(buffers, lengths, length, delimiter);
+  lcFree(buffers);
+  lcFree(lengths);
+  return string;
 }
 
 LCStringRef LCStringCreateFromStrings(LCStringRef strings[], size_t length) {
@@ -54,22 +145,17 @@ LCStringRef LCStringCreateFromStrings(LCStringRef strings[], size_t length) {
 }
 
 LCStringRef LCStringCreateFromStringArrayWithDelim(char* strings[], size_t length, char *delimiter) {
-  size_t totalLength = 1;
-  for (LCInteger i=0; i<length; i++) {
-    totalLength = totalLength + strlen(strings[i]);
-  }
-  if (delimiter) {
-    totalLength = totalLength + (length-1)*strlen(delimiter);
+  size_t *lengths = malloc(sizeof(size_t) * (length ? length : 1));
+  if (!lengths) {
+    perror("LCStringCreateFromStringArrayWithDelim");
+    return NULL;
   }
-  char buffer[totalLength];
-  buffer[0]='\0';
   for (LCInteger i=0; i<length; i++) {
-    if (i>0 && delimiter) {
-      strcat(buffer, delimiter);
-    }
-    strcat(buffer, strings[i]);
+    lengths[i] = strlen(strings[i]);
   }
-  return LCStringCreate(buffer);
+  LCStringRef string = stringCreateFromBuffers(strings, lengths, length, delimiter);
+  lcFree(lengths);
+  return string;
 }
 
 LCStringRef LCStringCreateFromStringArray(char* strings[], size_t length) {
@@ -80,87 +166,462 @@ LCStringRef LCStringCreateFromData(LCDataRef data) {
   return LCStringCreateFromChars((char*)LCDataDataRef(data), LCDataLength(data));
 }
 
+/*
+ interned strings live in a set split into shards with their own lock, so threads interning
+ different strings rarely wait for each other; strings are never removed from the set, so they
+ are made immortal and retaining or releasing them from any thread doesn't touch a count
+*/
+#define INTERN_SHARDS 16
+
+struct internShard {
+  pthread_mutex_t lock;
+  size_t length;
+  size_t capacity;
+  LCStringRef *strings;
+};
+
+static struct internShard internShards[INTERN_SHARDS];
+static pthread_once_t internShardsOnce = PTHREAD_ONCE_INIT;
+
+static void internShardsInit() {
+  for (LCInteger i=0; i<INTERN_SHARDS; i++) {
+    pthread_mutex_init(&internShards[i].lock, NULL);
+    internShards[i].length = 0;
+    internShards[i].capacity = 0;
+    internShards[i].strings = NULL;
+  }
+}
+
+static LCStringRef* internShardSlot(struct internShard *shard, size_t hashValue, char *chars, size_t length) {
+  size_t slot = (hashValue / INTERN_SHARDS) & (shard->capacity - 1);
+  while (shard->strings[slot]) {
+    stringDataRef data = objectData(shard->strings[slot]);
+    if (data->hashValue == hashValue && data->length == length && memcmp(data->chars, chars, length) == 0) {
+      break;
+    }
+    slot = (slot + 1) & (shard->capacity - 1);
+  }
+  return &shard->strings[slot];
+}
+
+static bool internShardGrow(struct internShard *shard) {
+  size_t oldCapacity = shard->capacity;
+  LCStringRef *oldStrings = shard->strings;
+  size_t newCapacity = oldCapacity ? oldCapacity * 2 : 64;
+  LCStringRef *newStrings = calloc(newCapacity, sizeof(LCStringRef));
+  if (!newStrings) {
+    perror("internShardGrow");
+    return false;
+  }
+  shard->capacity = newCapacity;
+  shard->strings = newStrings;
+  for (size_t i=0; i<oldCapacity; i++) {
+    if (oldStrings[i]) {
+      stringDataRef data = objectData(oldStrings[i]);
+      *internShardSlot(shard, data->hashValue, data->chars, data->length) = oldStrings[i];
+    }
+  }
+  lcFree(oldStrings);
+  return true;
+}
+
+LCStringRef LCStringCreateInternedFromChars(char* characters, size_t length) {
+  pthread_once(&internShardsOnce, internShardsInit);
+  size_t hashValue = hashBytes((LCByte*)characters, length);
+  hashValue = hashValue ? hashValue : 1;
+  struct internShard *shard = &internShards[hashValue % INTERN_SHARDS];
+  pthread_mutex_lock(&shard->lock);
+  if ((shard->length + 1) * 2 > shard->capacity && !internShardGrow(shard)) {
+    pthread_mutex_unlock(&shard->lock);
+    return NULL;
+  }
+  LCStringRef *slot = internShardSlot(shard, hashValue, characters, length);
+  if (!*slot) {
+    LCStringRef string = LCStringCreateFromChars(characters, length);
+    stringDataRef data = objectData(string);
+    data->hashValue = hashValue;
+    data->interned = true;
+    string->rCount = LC_IMMORTAL_RETAIN_COUNT;
+    *slot = string;
+    shard->length = shard->length + 1;
+  }
+  LCStringRef interned = *slot;
+  pthread_mutex_unlock(&shard->lock);
+  return interned;
+}
+
+LCStringRef LCStringCreateInterned(char *string) {
+  return LCStringCreateInternedFromChars(string, strlen(string));
+}
+
+bool LCStringIsInterned(LCStringRef string) {
+  stringDataRef data = stringDataOf(string);
+  return data->interned;
+}
+
+/*
+ the slice keeps the whole parent buffer alive, copy it with LCStringCreateFromChars to release it;
+ the parent is pinned so a context cache budget can't evict the buffer the slice points into;
+ slices of an LCMutableString are copies since its buffer moves when it grows
+*/
+LCStringRef LCStringCreateSlice(LCStringRef string, size_t offset, size_t length) {
+  stringDataRef parentData = stringDataOf(string);
+  if (offset > parentData->length) {
+    offset = parentData->length;
+  }
+  if (length > parentData->length - offset) {
+    length = parentData->length - offset;
+  }
+  if (objectType(string) == LCTypeMutableString) {
+    return LCStringCreateFromChars(parentData->chars + offset, length);
+  }
+  stringDataRef data = malloc(sizeof(struct stringData));
+  if (!data) {
+    return NULL;
+  }
+  data->length = length;
+  data->hashValue = 0;
+  data->chars = parentData->chars + offset;
+  data->parent = objectRetain(parentData->parent ? parentData->parent : string);
+  objectPin(data->parent);
+  data->cString = NULL;
+  data->interned = false;
+  return objectCreate(LCTypeString, data);
+}
+
 char* LCStringChars(LCStringRef string) {
-  return objectData(string);
+  stringDataRef data = stringDataOf(string);
+  if (!data->parent || data->chars[data->length] == '\0') {
+    return data->chars;
+  }
+  char *cString = __atomic_load_n(&data->cString, __ATOMIC_ACQUIRE);
+  if (cString) {
+    return cString;
+  }
+  char *copy = malloc(sizeof(char) * (data->length + 1));
+  if (!copy) {
+    perror("LCStringChars");
+    return NULL;
+  }
+  memcpy(copy, data->chars, data->length);
+  copy[data->length] = '\0';
+  if (!__atomic_compare_exchange_n(&data->cString, &cString, copy, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    lcFree(copy);
+    return cString;
+  }
+  return copy;
+}
+
+// copies the characters and a NUL into buffer, returns false if bufferLength can't hold them
+bool LCStringGetCString(LCStringRef string, char buffer[], size_t bufferLength) {
+  stringDataRef data = stringDataOf(string);
+  if (bufferLength < data->length + 1) {
+    return false;
+  }
+  memcpy(buffer, data->chars, data->length);
+  buffer[data->length] = '\0';
+  return true;
 }
 
 size_t LCStringLength(LCStringRef string) {
-  char* chars = objectData(string);
-  return strlen(chars);
+  uint64_t length;
+  if (objectStubMeta(string, LCMetaLength, &length)) {
+    return length;
+  }
+  stringDataRef data = stringDataOf(string);
+  return data->length;
+}
+
+// the hash value of an LCMutableString is not cached, it changes with the string
+size_t LCStringHashValue(LCStringRef string) {
+  stringDataRef data = stringDataOf(string);
+  if (objectType(string) == LCTypeMutableString) {
+    size_t hashValue = hashBytes((LCByte*)data->chars, data->length);
+    return hashValue ? hashValue : 1;
+  }
+  if (data->hashValue == 0) {
+    size_t hashValue = hashBytes((LCByte*)data->chars, data->length);
+    data->hashValue = hashValue ? hashValue : 1;
+  }
+  return data->hashValue;
 }
 
 bool LCStringEqual(LCStringRef string1, LCStringRef string2) {
-  return stringCompare(string1, string2) == LCEqual;
+  if (string1 == string2) {
+    return true;
+  }
+  stringDataRef data1 = stringDataOf(string1);
+  stringDataRef data2 = stringDataOf(string2);
+  if ((data1->interned && data2->interned) || data1->length != data2->length) {
+    return false;
+  }
+  if (data1->hashValue && data2->hashValue && data1->hashValue != data2->hashValue) {
+    return false;
+  }
+  return memcmp(data1->chars, data2->chars, data1->length) == 0;
 }
 
 bool LCStringEqualCString(LCStringRef string, char* cString) {
-  char* chars = objectData(string);
-  return strcmp(chars, cString) == 0;
+  stringDataRef data = stringDataOf(string);
+  size_t length = strlen(cString);
+  return data->length == length && memcmp(data->chars, cString, length) == 0;
 }
 
 LCArrayRef LCStringCreateTokens(LCStringRef string, char delimiter) {
-  char* cString = LCStringChars(string);
-  LCStringRef substrings[strlen(cString)/2];
-  LCInteger tokenStart = 0;
-  LCInteger substringCount = 0;
-  for (LCInteger i=0; i<strlen(cString); i++) {
-    if(cString[i] == delimiter) {
-      substrings[substringCount] = LCStringCreateFromChars(&cString[tokenStart], i-tokenStart);
+  stringDataRef data = stringDataOf(string);
+  char* chars = data->chars;
+  size_t length = data->length;
+  size_t substringCount = 1;
+  for (size_t i=0; i<length; i++) {
+    if (chars[i] == delimiter) {
       substringCount = substringCount + 1;
+    }
+  }
+  LCStringRef *substrings = malloc(sizeof(LCStringRef) * substringCount);
+  if (!substrings) {
+    perror("LCStringCreateTokens");
+    return NULL;
+  }
+  size_t tokenStart = 0;
+  size_t substringIndex = 0;
+  for (size_t i=0; i<=length; i++) {
+    if (i == length || chars[i] == delimiter) {
+      substrings[substringIndex] = LCStringCreateSlice(string, tokenStart, i-tokenStart);
+      substringIndex = substringIndex + 1;
       tokenStart = i+1;
     }
   }
-  substrings[substringCount] = LCStringCreate(&cString[tokenStart]);
-  substringCount = substringCount + 1;
   LCArrayRef array = LCArrayCreate(substrings, substringCount);
   for(LCInteger i=0; i<substringCount; i++) {
     objectRelease(substrings[i]);
   }
+  lcFree(substrings);
   return array;
 }
 
 LCCompare stringCompare(LCStringRef object1, LCStringRef object2) {
-  char* string1 = objectData(object1);
-  char* string2 = objectData(object2);
-  LCInteger string1Length = strlen(string1);
-  LCInteger string2Length = strlen(string2);
-  LCInteger maxCompareLength = string1Length;
-  if (maxCompareLength > string2Length) {
-    maxCompareLength = string2Length;
-  }
-  
-  for (LCInteger i=0; i<maxCompareLength; i++) {
-    if (string1[i] > string2[i]) {
-      return LCGreater;
-    }
-    if (string1[i] < string2[i]) {
-      return LCSmaller;
-    }
+  stringDataRef data1 = stringDataOf(object1);
+  stringDataRef data2 = stringDataOf(object2);
+  size_t compareLength = data1->length < data2->length ? data1->length : data2->length;
+  int result = memcmp(data1->chars, data2->chars, compareLength);
+  if (result > 0) {
+    return LCGreater;
+  }
+  if (result < 0) {
+    return LCSmaller;
   }
-  if (string1Length == string2Length) {
+  if (data1->length == data2->length) {
     return LCEqual;
   }
-  if (string1Length < string2Length) {
+  if (data1->length < data2->length) {
     return LCSmaller;
   } else {
     return LCGreater;
   }
 }
 
+// the 8 bytes at level*8 in big endian order, padded with zeros past the end of the string
+uint64_t stringSortKey(LCObjectRef object, LCInteger level) {
+  stringDataRef data = stringDataOf(object);
+  uint64_t key = 0;
+  for (size_t i=level*8; i<level*8+8; i++) {
+    key = key << 8;
+    if (i < data->length) {
+      key = key | (LCByte)data->chars[i];
+    }
+  }
+  return key;
+}
+
 void stringSerialize(LCObjectRef object, FILE *fp) {
-  fprintf(fp, "%s", LCStringChars(object));
+  stringDataRef data = stringDataOf(object);
+  fwrite(data->chars, sizeof(char), data->length, fp);
 }
 
 void* stringDeserialize(LCStringRef object, FILE *fp) {
   LCMutableDataRef data = LCMutableDataCreate(NULL, 0);
   LCMutableDataAppendFromFile(data, fp, fileLength(fp));
   char* serializedString = (char*)LCMutableDataDataRef(data);
-  char* buffer = malloc(sizeof(char)*strlen(serializedString));
-  if (buffer) {
-    strcpy(buffer, serializedString);
-    objectRelease(data);
-    return buffer;
-  } else {
+  size_t length = LCMutableDataLength(data);
+  stringDataRef stringData = stringCreateData(length);
+  if (stringData) {
+    memcpy(stringData->buffer, serializedString, length);
+  }
+  objectRelease(data);
+  return stringData;
+}
+
+size_t stringDataSize(LCObjectRef object) {
+  stringDataRef data = objectData(object);
+  return sizeof(struct stringData) + data->length + 1;
+}
+
+void stringDealloc(LCObjectRef object) {
+  stringDataRef data = objectData(object);
+  objectUnpin(data->parent);
+  objectRelease(data->parent);
+  lcFree(data->cString);
+  lcFree(data);
+}
+
+static bool mutableStringEnsureLength(mutableStringDataRef data, size_t length) {
+  if (data->string && data->capacity >= length) {
+    return true;
+  }
+  size_t newCapacity = data->capacity * 2 + length;
+  stringDataRef newString = realloc(data->string, sizeof(struct stringData) + newCapacity + 1);
+  if (!newString) {
+    perror("mutableStringEnsureLength");
+    return false;
+  }
+  if (!data->string) {
+    newString->length = 0;
+    newString->buffer[0] = '\0';
+  }
+  newString->hashValue = 0;
+  newString->chars = newString->buffer;
+  newString->parent = NULL;
+  newString->cString = NULL;
+  newString->interned = false;
+  data->string = newString;
+  data->capacity = newCapacity;
+  return true;
+}
+
+static mutableStringDataRef mutableStringCreateStruct(size_t capacity) {
+  mutableStringDataRef data = malloc(sizeof(struct mutableStringData));
+  if (data) {
+    data->capacity = 0;
+    data->string = NULL;
+    if (!mutableStringEnsureLength(data, capacity)) {
+      lcFree(data);
+      return NULL;
+    }
+  }
+  return data;
+}
+
+LCMutableStringRef LCMutableStringCreate(char *string) {
+  size_t length = strlen(string);
+  mutableStringDataRef data = mutableStringCreateStruct(length);
+  if (data) {
+    LCMutableStringRef mString = objectCreate(LCTypeMutableString, data);
+    LCMutableStringAppendChars(mString, string, length);
+    return mString;
+  }
+  return NULL;
+}
+
+size_t LCMutableStringLength(LCMutableStringRef string) {
+  uint64_t length;
+  if (objectStubMeta(string, LCMetaLength, &length)) {
+    return length;
+  }
+  mutableStringDataRef data = objectData(string);
+  return data->string->length;
+}
+
+char* LCMutableStringChars(LCMutableStringRef string) {
+  mutableStringDataRef data = objectData(string);
+  return data->string->chars;
+}
+
+void LCMutableStringAppendChars(LCMutableStringRef string, char *chars, size_t length) {
+  mutableStringDataRef data = objectData(string);
+  stringDataRef stringData = data->string;
+  if (!mutableStringEnsureLength(data, stringData->length + length)) {
+    return;
+  }
+  stringData = data->string;
+  memcpy(&(stringData->buffer[stringData->length]), chars, length);
+  stringData->length = stringData->length + length;
+  stringData->buffer[stringData->length] = '\0';
+}
+
+void LCMutableStringAppend(LCMutableStringRef string, char *chars) {
+  LCMutableStringAppendChars(string, chars, strlen(chars));
+}
+
+void LCMutableStringAppendString(LCMutableStringRef string, LCStringRef other) {
+  stringDataRef otherData = stringDataOf(other);
+  LCMutableStringAppendChars(string, otherData->chars, otherData->length);
+}
+
+void LCMutableStringAppendData(LCMutableStringRef string, LCDataRef data) {
+  LCMutableStringAppendChars(string, (char*)LCDataDataRef(data), LCDataLength(data));
+}
+
+void LCMutableStringAppendf(LCMutableStringRef string, char *format, ...) {
+  mutableStringDataRef data = objectData(string);
+  va_list args;
+  va_start(args, format);
+  size_t available = data->capacity - data->string->length;
+  int written = vsnprintf(&(data->string->buffer[data->string->length]), available + 1, format, args);
+  va_end(args);
+  if (written < 0) {
+    perror("LCMutableStringAppendf");
+    data->string->buffer[data->string->length] = '\0';
+    return;
+  }
+  if (written > available) {
+    if (!mutableStringEnsureLength(data, data->string->length + written)) {
+      data->string->buffer[data->string->length] = '\0';
+      return;
+    }
+    va_start(args, format);
+    vsnprintf(&(data->string->buffer[data->string->length]), written + 1, format, args);
+    va_end(args);
+  }
+  data->string->length = data->string->length + written;
+}
+
+void LCMutableStringAppendFromFile(LCMutableStringRef string, FILE* fp, size_t fileLength) {
+  if (fileLength == -1) {
+    fileLength = 10;
+  }
+  mutableStringDataRef data = objectData(string);
+  while (!feof(fp) && !ferror(fp)) {
+    if (!mutableStringEnsureLength(data, data->string->length + fileLength)) {
+      return;
+    }
+    stringDataRef stringData = data->string;
+    size_t lengthRead = fread(&(stringData->buffer[stringData->length]), sizeof(char),
+                              data->capacity - stringData->length, fp);
+    stringData->length = stringData->length + lengthRead;
+    stringData->buffer[stringData->length] = '\0';
+    fileLength = fileLength * 2;
+  }
+}
+
+LCStringRef LCMutableStringCreateString(LCMutableStringRef string) {
+  mutableStringDataRef data = objectData(string);
+  stringDataRef stringData = data->string;
+  stringDataRef shrunk = realloc(stringData, sizeof(struct stringData) + stringData->length + 1);
+  if (shrunk) {
+    stringData = shrunk;
+  }
+  stringData->chars = stringData->buffer;
+  data->string = NULL;
+  data->capacity = 0;
+  mutableStringEnsureLength(data, 0);
+  return objectCreate(LCTypeString, stringData);
+}
+
+void* mutableStringDeserialize(LCObjectRef object, FILE* fd) {
+  stringDataRef stringData = stringDeserialize(object, fd);
+  mutableStringDataRef data = malloc(sizeof(struct mutableStringData));
+  if (!data || !stringData) {
+    lcFree(data);
+    lcFree(stringData);
     return NULL;
   }
+  data->capacity = stringData->length;
+  data->string = stringData;
+  return data;
+}
+
+void mutableStringDealloc(LCObjectRef object) {
+  mutableStringDataRef data = objectData(object);
+  lcFree(data->string);
+  lcFree(data);
 }
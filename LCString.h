@@ -6,8 +6,43 @@
 #include "LCArray.h"
 #include "LCData.h"
 
+/*
+ - length excludes the terminating NUL that is always written after the characters,
+   so strings may contain embedded NULs and LCStringChars still works as a C string
+ - hashValue caches hashBytes of the characters, 0 means it was not computed yet
+ - slices have no buffer of their own, chars points into the buffer of parent which
+   they retain; a slice that does not end where its parent ends is not NUL terminated,
+   LCStringChars then creates the NUL terminated copy cString on first use, threads racing
+   to create it publish one copy; LCStringGetCString copies into a caller owned buffer instead
+ - interned strings are unique per content, two different interned strings are never equal;
+   they are immortal, so threads can share them whatever the release mode
+*/
+struct stringData {
+  size_t length;
+  size_t hashValue;
+  char *chars;
+  LCStringRef parent;
+  char *cString;
+  bool interned;
+  char buffer[];
+};
+
+extern struct LCType stringType;
 extern LCTypeRef LCTypeString;
 
+typedef LCObjectRef LCMutableStringRef;
+extern LCTypeRef LCTypeMutableString;
+
+// defines an immortal LCString for a string literal, the characters stay in read only data
+#define LCStaticString(name, literal) \
+  static struct stringData name##Data = {.length = sizeof(literal) - 1, .chars = (literal)}; \
+  LCStaticObject(name, stringType, name##Data)
+
+// defines a temporary LCString on the stack that borrows a NUL terminated C string, see LCStackObject
+#define LCStackString(name, cString) \
+  struct stringData name##Data = {.length = strlen(cString), .chars = (cString)}; \
+  LCStackObject(name, stringType, name##Data)
+
 LCStringRef LCStringCreate(char *string);
 LCStringRef LCStringCreateFromHash(LCContextRef context, char hash[HASH_LENGTH]);
 LCStringRef LCStringCreateFromChars(char* characters, size_t length);
@@ -16,10 +51,27 @@ LCStringRef LCStringCreateFromStringsWithDelim(LCStringRef strings[], size_t len
 LCStringRef LCStringCreateFromStringArray(char* characters[], size_t length);
 LCStringRef LCStringCreateFromStringArrayWithDelim(char* strings[], size_t length, char *delimiter);
 LCStringRef LCStringCreateFromData(LCDataRef data);
+LCStringRef LCStringCreateSlice(LCStringRef string, size_t offset, size_t length);
+LCStringRef LCStringCreateInterned(char *string);
+LCStringRef LCStringCreateInternedFromChars(char* characters, size_t length);
+bool LCStringIsInterned(LCStringRef string);
 size_t LCStringLength(LCStringRef string);
+size_t LCStringHashValue(LCStringRef string);
 bool LCStringEqual(LCStringRef string1, LCStringRef string2);
 bool LCStringEqualCString(LCStringRef string, char* cString);
 char* LCStringChars(LCStringRef string);
+bool LCStringGetCString(LCStringRef string, char buffer[], size_t bufferLength);
 LCArrayRef LCStringCreateTokens(LCStringRef string, char delimiter);
 
+LCMutableStringRef LCMutableStringCreate(char *string);
+size_t LCMutableStringLength(LCMutableStringRef string);
+char* LCMutableStringChars(LCMutableStringRef string);
+void LCMutableStringAppend(LCMutableStringRef string, char *chars);
+void LCMutableStringAppendChars(LCMutableStringRef string, char *chars, size_t length);
+void LCMutableStringAppendString(LCMutableStringRef string, LCStringRef other);
+void LCMutableStringAppendData(LCMutableStringRef string, LCDataRef data);
+void LCMutableStringAppendf(LCMutableStringRef string, char *format, ...);
+void LCMutableStringAppendFromFile(LCMutableStringRef string, FILE* fp, size_t fileLength);
+LCStringRef LCMutableStringCreateString(LCMutableStringRef string);
+
 #endif
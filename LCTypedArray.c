@@ -0,0 +1,547 @@
+
+#include "LCTypedArray.h"
+#include "LCUtils.h"
+#include <sys/mman.h>
+
+#define TYPED_ARRAY_HEADER_LENGTH 16
+
+typedef struct typedArrayData* typedArrayDataRef;
+
+LCCompare typedArrayCompare(LCObjectRef object1, LCObjectRef object2);
+void typedArrayDealloc(LCObjectRef object);
+size_t typedArrayDataSize(LCObjectRef object);
+void typedArraySerialize(LCObjectRef object, FILE *fd);
+void* typedArrayDeserialize(LCObjectRef object, FILE *fd);
+
+/*
+ - values either point to a malloced buffer or into a read-only mapping of the store file
+ - the file layout is a 16 byte header (element type, reserved, length) followed by the raw values
+   in host byte order, so a stored array can be mapped instead of read
+*/
+struct typedArrayData {
+  LCElementType elementType;
+  size_t length;
+  void *values;
+  void *mapping;
+  size_t mappingLength;
+};
+
+struct typedArrayHeader {
+  uint32_t elementType;
+  uint32_t reserved;
+  uint64_t length;
+};
+
+struct LCType typeTypedArray = {
+  .name = "LCTypedArray",
+  .immutable = true,
+  .serializationFormat = LCBinary,
+  .dealloc = typedArrayDealloc,
+  .dataSize = typedArrayDataSize,
+  .length = LCTypedArrayLength,
+  .compare = typedArrayCompare,
+  .serializeData = typedArraySerialize,
+  .deserializeData = typedArrayDeserialize
+};
+
+LCTypeRef LCTypeTypedArray = &typeTypedArray;
+
+static typedArrayDataRef typedArrayCreateStruct() {
+  typedArrayDataRef newArray = malloc(sizeof(struct typedArrayData));
+  if (newArray) {
+    newArray->elementType = LCElementInt32;
+    newArray->length = 0;
+    newArray->values = NULL;
+    newArray->mapping = NULL;
+    newArray->mappingLength = 0;
+  }
+  return newArray;
+}
+
+size_t LCTypedArrayElementSize(LCElementType elementType) {
+  switch (elementType) {
+    case LCElementInt32:
+      return sizeof(int32_t);
+    case LCElementInt64:
+      return sizeof(int64_t);
+    case LCElementFloat:
+      return sizeof(float);
+    case LCElementDouble:
+      return sizeof(double);
+  }
+  return 0;
+}
+
+static LCTypedArrayRef typedArrayCreateNoCopy(LCElementType elementType, void *values, size_t length) {
+  typedArrayDataRef newArray = typedArrayCreateStruct();
+  if (newArray) {
+    newArray->elementType = elementType;
+    newArray->values = values;
+    newArray->length = length;
+    return objectCreate(LCTypeTypedArray, newArray);
+  }
+  return NULL;
+}
+
+LCTypedArrayRef LCTypedArrayCreate(LCElementType elementType, void *values, size_t length) {
+  size_t valuesLength = LCTypedArrayElementSize(elementType) * length;
+  void *buffer = malloc(valuesLength ? valuesLength : 1);
+  if (buffer) {
+    memcpy(buffer, values, valuesLength);
+    return typedArrayCreateNoCopy(elementType, buffer, length);
+  }
+  perror("LCTypedArrayCreate");
+  return NULL;
+}
+
+LCTypedArrayRef LCTypedArrayCreateFromHash(LCContextRef context, char hash[HASH_LENGTH]) {
+  return objectCreateFromContext(context, LCTypeTypedArray, hash);
+}
+
+LCElementType LCTypedArrayElementType(LCTypedArrayRef array) {
+  typedArrayDataRef data = objectData(array);
+  return data->elementType;
+}
+
+size_t LCTypedArrayLength(LCTypedArrayRef array) {
+  uint64_t length;
+  if (objectStubMeta(array, LCMetaLength, &length)) {
+    return length;
+  }
+  typedArrayDataRef data = objectData(array);
+  return data->length;
+}
+
+void* LCTypedArrayValues(LCTypedArrayRef array) {
+  typedArrayDataRef data = objectData(array);
+  return data->values;
+}
+
+bool LCTypedArrayIsMapped(LCTypedArrayRef array) {
+  typedArrayDataRef data = objectData(array);
+  return data->mapping != NULL;
+}
+
+double LCTypedArrayValueAtIndex(LCTypedArrayRef array, LCInteger index) {
+  typedArrayDataRef data = objectData(array);
+  switch (data->elementType) {
+    case LCElementInt32:
+      return ((int32_t*)data->values)[index];
+    case LCElementInt64:
+      return ((int64_t*)data->values)[index];
+    case LCElementFloat:
+      return ((float*)data->values)[index];
+    case LCElementDouble:
+      return ((double*)data->values)[index];
+  }
+  return NAN;
+}
+
+/*
+ the kernels keep four independent accumulators so the compiler can vectorize the loops
+ without reassociating floating point math on its own; sums of every element type accumulate
+ in double, integer accumulators could overflow
+*/
+#define TYPED_ARRAY_KERNELS(suffix, valueType, sumType) \
+static double typedArraySum##suffix(const valueType *restrict values, size_t length) { \
+  sumType sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0; \
+  size_t i = 0; \
+  for (; i+4 <= length; i+=4) { \
+    sum0 += values[i]; \
+    sum1 += values[i+1]; \
+    sum2 += values[i+2]; \
+    sum3 += values[i+3]; \
+  } \
+  for (; i<length; i++) { \
+    sum0 += values[i]; \
+  } \
+  return (double)((sum0 + sum1) + (sum2 + sum3)); \
+} \
+static double typedArrayMin##suffix(const valueType *restrict values, size_t length) { \
+  if (length == 0) { \
+    return NAN; \
+  } \
+  valueType min0 = values[0], min1 = values[0], min2 = values[0], min3 = values[0]; \
+  size_t i = 0; \
+  for (; i+4 <= length; i+=4) { \
+    min0 = values[i] < min0 ? values[i] : min0; \
+    min1 = values[i+1] < min1 ? values[i+1] : min1; \
+    min2 = values[i+2] < min2 ? values[i+2] : min2; \
+    min3 = values[i+3] < min3 ? values[i+3] : min3; \
+  } \
+  for (; i<length; i++) { \
+    min0 = values[i] < min0 ? values[i] : min0; \
+  } \
+  min0 = min1 < min0 ? min1 : min0; \
+  min2 = min3 < min2 ? min3 : min2; \
+  return (double)(min2 < min0 ? min2 : min0); \
+} \
+static double typedArrayMax##suffix(const valueType *restrict values, size_t length) { \
+  if (length == 0) { \
+    return NAN; \
+  } \
+  valueType max0 = values[0], max1 = values[0], max2 = values[0], max3 = values[0]; \
+  size_t i = 0; \
+  for (; i+4 <= length; i+=4) { \
+    max0 = values[i] > max0 ? values[i] : max0; \
+    max1 = values[i+1] > max1 ? values[i+1] : max1; \
+    max2 = values[i+2] > max2 ? values[i+2] : max2; \
+    max3 = values[i+3] > max3 ? values[i+3] : max3; \
+  } \
+  for (; i<length; i++) { \
+    max0 = values[i] > max0 ? values[i] : max0; \
+  } \
+  max0 = max1 > max0 ? max1 : max0; \
+  max2 = max3 > max2 ? max3 : max2; \
+  return (double)(max2 > max0 ? max2 : max0); \
+} \
+static double typedArrayDot##suffix(const valueType *restrict values1, const valueType *restrict values2, size_t length) { \
+  sumType sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0; \
+  size_t i = 0; \
+  for (; i+4 <= length; i+=4) { \
+    sum0 += (sumType)values1[i] * values2[i]; \
+    sum1 += (sumType)values1[i+1] * values2[i+1]; \
+    sum2 += (sumType)values1[i+2] * values2[i+2]; \
+    sum3 += (sumType)values1[i+3] * values2[i+3]; \
+  } \
+  for (; i<length; i++) { \
+    sum0 += (sumType)values1[i] * values2[i]; \
+  } \
+  return (double)((sum0 + sum1) + (sum2 + sum3)); \
+}
+
+TYPED_ARRAY_KERNELS(Int32, int32_t, double)
+TYPED_ARRAY_KERNELS(Int64, int64_t, double)
+TYPED_ARRAY_KERNELS(Float, float, double)
+TYPED_ARRAY_KERNELS(Double, double, double)
+
+double LCTypedArraySum(LCTypedArrayRef array) {
+  typedArrayDataRef data = objectData(array);
+  switch (data->elementType) {
+    case LCElementInt32:
+      return typedArraySumInt32(data->values, data->length);
+    case LCElementInt64:
+      return typedArraySumInt64(data->values, data->length);
+    case LCElementFloat:
+      return typedArraySumFloat(data->values, data->length);
+    case LCElementDouble:
+      return typedArraySumDouble(data->values, data->length);
+  }
+  return NAN;
+}
+
+double LCTypedArrayMin(LCTypedArrayRef array) {
+  typedArrayDataRef data = objectData(array);
+  switch (data->elementType) {
+    case LCElementInt32:
+      return typedArrayMinInt32(data->values, data->length);
+    case LCElementInt64:
+      return typedArrayMinInt64(data->values, data->length);
+    case LCElementFloat:
+      return typedArrayMinFloat(data->values, data->length);
+    case LCElementDouble:
+      return typedArrayMinDouble(data->values, data->length);
+  }
+  return NAN;
+}
+
+double LCTypedArrayMax(LCTypedArrayRef array) {
+  typedArrayDataRef data = objectData(array);
+  switch (data->elementType) {
+    case LCElementInt32:
+      return typedArrayMaxInt32(data->values, data->length);
+    case LCElementInt64:
+      return typedArrayMaxInt64(data->values, data->length);
+    case LCElementFloat:
+      return typedArrayMaxFloat(data->values, data->length);
+    case LCElementDouble:
+      return typedArrayMaxDouble(data->values, data->length);
+  }
+  return NAN;
+}
+
+double LCTypedArrayDot(LCTypedArrayRef array1, LCTypedArrayRef array2) {
+  typedArrayDataRef data1 = objectData(array1);
+  typedArrayDataRef data2 = objectData(array2);
+  if (data1->elementType != data2->elementType) {
+    perror("LCTypedArrayDot: element types differ");
+    return NAN;
+  }
+  size_t length = data1->length < data2->length ? data1->length : data2->length;
+  switch (data1->elementType) {
+    case LCElementInt32:
+      return typedArrayDotInt32(data1->values, data2->values, length);
+    case LCElementInt64:
+      return typedArrayDotInt64(data1->values, data2->values, length);
+    case LCElementFloat:
+      return typedArrayDotFloat(data1->values, data2->values, length);
+    case LCElementDouble:
+      return typedArrayDotDouble(data1->values, data2->values, length);
+  }
+  return NAN;
+}
+
+/*
+ sorting maps every value to an unsigned key with the same order (flip the sign bit of integers,
+ flip all bits of negative floats) and runs an LSD radix sort over the keys, skipping byte
+ positions that are identical in every key
+*/
+static void radixSort32(uint32_t *keys, uint32_t *buffer, size_t length) {
+  uint32_t *from = keys;
+  uint32_t *to = buffer;
+  for (LCInteger shift=0; shift<32; shift+=8) {
+    size_t counts[256] = {0};
+    for (size_t i=0; i<length; i++) {
+      counts[(from[i] >> shift) & 0xff]++;
+    }
+    if (counts[(from[0] >> shift) & 0xff] == length) {
+      continue;
+    }
+    size_t offset = 0;
+    for (LCInteger b=0; b<256; b++) {
+      size_t count = counts[b];
+      counts[b] = offset;
+      offset = offset + count;
+    }
+    for (size_t i=0; i<length; i++) {
+      to[counts[(from[i] >> shift) & 0xff]++] = from[i];
+    }
+    uint32_t *swap = from;
+    from = to;
+    to = swap;
+  }
+  if (from != keys) {
+    memcpy(keys, from, sizeof(uint32_t) * length);
+  }
+}
+
+static void radixSort64(uint64_t *keys, uint64_t *buffer, size_t length) {
+  uint64_t *from = keys;
+  uint64_t *to = buffer;
+  for (LCInteger shift=0; shift<64; shift+=8) {
+    size_t counts[256] = {0};
+    for (size_t i=0; i<length; i++) {
+      counts[(from[i] >> shift) & 0xff]++;
+    }
+    if (counts[(from[0] >> shift) & 0xff] == length) {
+      continue;
+    }
+    size_t offset = 0;
+    for (LCInteger b=0; b<256; b++) {
+      size_t count = counts[b];
+      counts[b] = offset;
+      offset = offset + count;
+    }
+    for (size_t i=0; i<length; i++) {
+      to[counts[(from[i] >> shift) & 0xff]++] = from[i];
+    }
+    uint64_t *swap = from;
+    from = to;
+    to = swap;
+  }
+  if (from != keys) {
+    memcpy(keys, from, sizeof(uint64_t) * length);
+  }
+}
+
+static uint32_t floatBitsToKey(uint32_t bits) {
+  return (bits & 0x80000000u) ? ~bits : (bits ^ 0x80000000u);
+}
+
+static uint32_t keyToFloatBits(uint32_t key) {
+  return (key & 0x80000000u) ? (key ^ 0x80000000u) : ~key;
+}
+
+static uint64_t doubleBitsToKey(uint64_t bits) {
+  return (bits & 0x8000000000000000ull) ? ~bits : (bits ^ 0x8000000000000000ull);
+}
+
+static uint64_t keyToDoubleBits(uint64_t key) {
+  return (key & 0x8000000000000000ull) ? (key ^ 0x8000000000000000ull) : ~key;
+}
+
+LCTypedArrayRef LCTypedArrayCreateSorted(LCTypedArrayRef array) {
+  typedArrayDataRef data = objectData(array);
+  size_t length = data->length;
+  size_t elementSize = LCTypedArrayElementSize(data->elementType);
+  void *values = malloc(elementSize * (length ? length : 1));
+  void *buffer = malloc(elementSize * (length ? length : 1));
+  if (!values || !buffer) {
+    perror("LCTypedArrayCreateSorted");
+    lcFree(values);
+    lcFree(buffer);
+    return NULL;
+  }
+  memcpy(values, data->values, elementSize * length);
+  if (length > 1) {
+    if (elementSize == sizeof(uint32_t)) {
+      uint32_t *keys = values;
+      for (size_t i=0; i<length; i++) {
+        keys[i] = data->elementType == LCElementFloat ? floatBitsToKey(keys[i]) : keys[i] ^ 0x80000000u;
+      }
+      radixSort32(keys, buffer, length);
+      for (size_t i=0; i<length; i++) {
+        keys[i] = data->elementType == LCElementFloat ? keyToFloatBits(keys[i]) : keys[i] ^ 0x80000000u;
+      }
+    } else {
+      uint64_t *keys = values;
+      for (size_t i=0; i<length; i++) {
+        keys[i] = data->elementType == LCElementDouble ? doubleBitsToKey(keys[i]) : keys[i] ^ 0x8000000000000000ull;
+      }
+      radixSort64(keys, buffer, length);
+      for (size_t i=0; i<length; i++) {
+        keys[i] = data->elementType == LCElementDouble ? keyToDoubleBits(keys[i]) : keys[i] ^ 0x8000000000000000ull;
+      }
+    }
+  }
+  lcFree(buffer);
+  return typedArrayCreateNoCopy(data->elementType, values, length);
+}
+
+static bool elementTypeIsInteger(LCElementType elementType) {
+  return elementType == LCElementInt32 || elementType == LCElementInt64;
+}
+
+static int64_t typedArrayIntegerAtIndex(typedArrayDataRef data, size_t index) {
+  if (data->elementType == LCElementInt32) {
+    return ((int32_t*)data->values)[index];
+  }
+  return ((int64_t*)data->values)[index];
+}
+
+static double typedArrayRealAtIndex(typedArrayDataRef data, size_t index) {
+  if (data->elementType == LCElementFloat) {
+    return ((float*)data->values)[index];
+  }
+  return ((double*)data->values)[index];
+}
+
+/*
+ elements are compared in their own type, integers never go through double, so int64 values above 2^53
+ stay apart; NaN orders after every other value and equals NaN, like in LCNumber
+*/
+LCCompare typedArrayCompare(LCObjectRef object1, LCObjectRef object2) {
+  typedArrayDataRef data1 = objectData(object1);
+  typedArrayDataRef data2 = objectData(object2);
+  bool integers1 = elementTypeIsInteger(data1->elementType);
+  bool integers2 = elementTypeIsInteger(data2->elementType);
+  size_t checkLength = data1->length < data2->length ? data1->length : data2->length;
+  for (size_t i=0; i<checkLength; i++) {
+    LCCompare result;
+    if (integers1 && integers2) {
+      int64_t value1 = typedArrayIntegerAtIndex(data1, i);
+      int64_t value2 = typedArrayIntegerAtIndex(data2, i);
+      result = value1 == value2 ? LCEqual : (value1 > value2 ? LCGreater : LCSmaller);
+    } else if (integers1) {
+      result = compareIntegerToDouble(typedArrayIntegerAtIndex(data1, i), typedArrayRealAtIndex(data2, i));
+    } else if (integers2) {
+      result = compareIntegerToDouble(typedArrayIntegerAtIndex(data2, i), typedArrayRealAtIndex(data1, i));
+      result = result == LCEqual ? LCEqual : (result == LCGreater ? LCSmaller : LCGreater);
+    } else {
+      result = compareDoubles(typedArrayRealAtIndex(data1, i), typedArrayRealAtIndex(data2, i));
+    }
+    if (result != LCEqual) {
+      return result;
+    }
+  }
+  if (data1->length == data2->length) {
+    return LCEqual;
+  }
+  return data1->length > data2->length ? LCGreater : LCSmaller;
+}
+
+size_t typedArrayDataSize(LCObjectRef object) {
+  typedArrayDataRef data = objectData(object);
+  return sizeof(struct typedArrayData) + LCTypedArrayElementSize(data->elementType) * data->length;
+}
+
+void typedArrayDealloc(LCObjectRef object) {
+  typedArrayDataRef data = objectData(object);
+  if (data->mapping) {
+    munmap(data->mapping, data->mappingLength);
+  } else {
+    lcFree(data->values);
+  }
+  lcFree(data);
+}
+
+void typedArraySerialize(LCObjectRef object, FILE *fd) {
+  typedArrayDataRef data = objectData(object);
+  struct typedArrayHeader header = {
+    .elementType = data->elementType,
+    .reserved = 0,
+    .length = data->length
+  };
+  fwrite(&header, TYPED_ARRAY_HEADER_LENGTH, 1, fd);
+  fwrite(data->values, LCTypedArrayElementSize(data->elementType), data->length, fd);
+}
+
+// the header comes from the file, its type must be known and its values must fit in available bytes
+static bool typedArrayHeaderValid(struct typedArrayHeader *header, size_t available) {
+  size_t elementSize = LCTypedArrayElementSize(header->elementType);
+  if (elementSize == 0 || header->length > available / elementSize) {
+    perror(ErrorInvalidTypedArray);
+    return false;
+  }
+  return true;
+}
+
+static bool typedArrayMapFile(typedArrayDataRef data, FILE *fd, bool *invalid) {
+  int fileDescriptor = fileno(fd);
+  struct stat stat;
+  if (fileDescriptor == -1 || ftell(fd) != 0 || fstat(fileDescriptor, &stat) != 0 || !S_ISREG(stat.st_mode) ||
+      stat.st_size < TYPED_ARRAY_HEADER_LENGTH) {
+    return false;
+  }
+  void *mapping = mmap(NULL, stat.st_size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+  struct typedArrayHeader *header = mapping;
+  if (!typedArrayHeaderValid(header, stat.st_size - TYPED_ARRAY_HEADER_LENGTH)) {
+    munmap(mapping, stat.st_size);
+    *invalid = true;
+    return false;
+  }
+  data->elementType = header->elementType;
+  data->length = header->length;
+  data->values = (LCByte*)mapping + TYPED_ARRAY_HEADER_LENGTH;
+  data->mapping = mapping;
+  data->mappingLength = stat.st_size;
+  return true;
+}
+
+/*
+ - an invalid header leaves the array empty
+ - streams that can't be mapped are only bounded by the file size when they are regular files
+*/
+void* typedArrayDeserialize(LCObjectRef object, FILE *fd) {
+  typedArrayDataRef data = typedArrayCreateStruct();
+  bool invalid = false;
+  if (!data || typedArrayMapFile(data, fd, &invalid) || invalid) {
+    return data;
+  }
+  struct typedArrayHeader header;
+  if (fread(&header, TYPED_ARRAY_HEADER_LENGTH, 1, fd) != 1) {
+    return data;
+  }
+  size_t available = SIZE_MAX - 1;
+  int fileDescriptor = fileno(fd);
+  struct stat stat;
+  long offset = ftell(fd);
+  if (fileDescriptor != -1 && offset >= 0 && fstat(fileDescriptor, &stat) == 0 && S_ISREG(stat.st_mode)) {
+    available = stat.st_size > offset ? stat.st_size - offset : 0;
+  }
+  if (!typedArrayHeaderValid(&header, available)) {
+    return data;
+  }
+  size_t elementSize = LCTypedArrayElementSize(header.elementType);
+  data->elementType = header.elementType;
+  data->values = malloc(elementSize * (header.length ? header.length : 1));
+  if (data->values) {
+    data->length = fread(data->values, elementSize, header.length, fd);
+  } else {
+    perror("typedArrayDeserialize");
+  }
+  return data;
+}
@@ -0,0 +1,31 @@
+
+#ifndef LivelyC_LCTypedArray_h
+#define LivelyC_LCTypedArray_h
+
+#include "LCCore.h"
+
+typedef enum {
+  LCElementInt32,
+  LCElementInt64,
+  LCElementFloat,
+  LCElementDouble
+} LCElementType;
+
+typedef LCObjectRef LCTypedArrayRef;
+extern LCTypeRef LCTypeTypedArray;
+
+LCTypedArrayRef LCTypedArrayCreate(LCElementType elementType, void *values, size_t length);
+LCTypedArrayRef LCTypedArrayCreateFromHash(LCContextRef context, char hash[HASH_LENGTH]);
+LCElementType LCTypedArrayElementType(LCTypedArrayRef array);
+size_t LCTypedArrayElementSize(LCElementType elementType);
+size_t LCTypedArrayLength(LCTypedArrayRef array);
+void* LCTypedArrayValues(LCTypedArrayRef array);
+bool LCTypedArrayIsMapped(LCTypedArrayRef array);
+double LCTypedArrayValueAtIndex(LCTypedArrayRef array, LCInteger index);
+double LCTypedArraySum(LCTypedArrayRef array);
+double LCTypedArrayMin(LCTypedArrayRef array);
+double LCTypedArrayMax(LCTypedArrayRef array);
+double LCTypedArrayDot(LCTypedArrayRef array1, LCTypedArrayRef array2);
+LCTypedArrayRef LCTypedArrayCreateSorted(LCTypedArrayRef array);
+
+#endif
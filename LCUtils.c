@@ -56,6 +56,125 @@ LCArrayRef createPathArray(LCStringRef path) {
   return LCStringCreateTokens(path, '/');
 }
 
+// FNV-1a, used for in-memory hash tables; digests for the store are SHA-1
+size_t hashBytes(LCByte data[], size_t length) {
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i=0; i<length; i++) {
+    hash = (hash ^ data[i]) * 1099511628211ull;
+  }
+  return (size_t)hash;
+}
+
+/*
+ exact for every integer, integers are never converted to double: the double is range checked and
+ its integral part compared as an integer, then its fractional part decides; NaN orders after every
+ other number and equals NaN
+*/
+LCCompare compareIntegerToDouble(int64_t integer, double real) {
+  if (isnan(real) || real >= 9223372036854775808.0) {
+    return LCSmaller;
+  }
+  if (real < -9223372036854775808.0) {
+    return LCGreater;
+  }
+  int64_t integral = (int64_t)real;
+  if (integer != integral) {
+    return integer > integral ? LCGreater : LCSmaller;
+  }
+  double fraction = real - (double)integral;
+  if (fraction == 0) {
+    return LCEqual;
+  }
+  return fraction > 0 ? LCSmaller : LCGreater;
+}
+
+LCCompare compareDoubles(double real1, double real2) {
+  if (isnan(real1) || isnan(real2)) {
+    if (isnan(real1) && isnan(real2)) {
+      return LCEqual;
+    }
+    return isnan(real1) ? LCGreater : LCSmaller;
+  }
+  if (real1 == real2) {
+    return LCEqual;
+  }
+  return real1 > real2 ? LCGreater : LCSmaller;
+}
+
+// one chunk per online processor, but no chunk shorter than minChunkLength
+size_t parallelChunkCount(size_t length, size_t minChunkLength) {
+  long processors = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t chunks = processors > 1 ? processors : 1;
+  if (minChunkLength == 0) {
+    minChunkLength = 1;
+  }
+  if (chunks > length / minChunkLength) {
+    chunks = length / minChunkLength;
+  }
+  return chunks > 0 ? chunks : 1;
+}
+
+struct parallelChunk {
+  void *cookie;
+  parallelChunkFun fun;
+  LCInteger chunk;
+  size_t start;
+  size_t end;
+};
+
+static void* parallelChunkRun(void *argument) {
+  struct parallelChunk *chunk = argument;
+  chunk->fun(chunk->cookie, chunk->chunk, chunk->start, chunk->end);
+  return NULL;
+}
+
+/*
+ splits 0..length into parallelChunkCount(length, minChunkLength) consecutive ranges and calls fun
+ for each of them concurrently, the first range runs on the calling thread; returns after all ranges
+ are done
+*/
+void parallelFor(size_t length, size_t minChunkLength, void *cookie, parallelChunkFun fun) {
+  size_t chunks = parallelChunkCount(length, minChunkLength);
+  if (chunks == 1) {
+    fun(cookie, 0, 0, length);
+    return;
+  }
+  struct parallelChunk *chunkInfos = malloc(sizeof(struct parallelChunk) * chunks);
+  pthread_t *threads = malloc(sizeof(pthread_t) * chunks);
+  bool *started = calloc(chunks, sizeof(bool));
+  if (!chunkInfos || !threads || !started) {
+    perror("parallelFor");
+    lcFree(started);
+    lcFree(threads);
+    lcFree(chunkInfos);
+    for (size_t i=0; i<chunks; i++) {
+      fun(cookie, i, length * i / chunks, length * (i+1) / chunks);
+    }
+    return;
+  }
+  for (LCInteger i=0; i<chunks; i++) {
+    chunkInfos[i].cookie = cookie;
+    chunkInfos[i].fun = fun;
+    chunkInfos[i].chunk = i;
+    chunkInfos[i].start = length * i / chunks;
+    chunkInfos[i].end = length * (i+1) / chunks;
+  }
+  for (LCInteger i=1; i<chunks; i++) {
+    started[i] = pthread_create(&threads[i], NULL, parallelChunkRun, &chunkInfos[i]) == 0;
+  }
+  parallelChunkRun(&chunkInfos[0]);
+  for (LCInteger i=1; i<chunks; i++) {
+    if (started[i]) {
+      pthread_join(threads[i], NULL);
+    } else {
+      parallelChunkRun(&chunkInfos[i]);
+    }
+  }
+  lcFree(started);
+  lcFree(threads);
+  lcFree(chunkInfos);
+}
+
 void writeToFile(LCByte data[], size_t length, char* filePath) {
   FILE *fp = fopen(filePath, "w");
   fwrite(data, sizeof(unsigned char), length, fp);
@@ -12,6 +12,8 @@
 #include "LCArray.h"
 #include "LCData.h"
 
+typedef void(*parallelChunkFun)(void *cookie, LCInteger chunk, size_t start, size_t end);
+
 void LCPrintf(LCObjectRef object);
 
 char hexDigitToASCIChar(char hexDigit);
@@ -21,6 +23,11 @@ LCByte hexDigitsToByte(char *hexDigits);
 void createHexString(LCByte data[], size_t length, char buffer[]);
 LCDataRef createDataFromHexString(LCStringRef hexString);
 LCArrayRef createPathArray(LCStringRef path);
+size_t hashBytes(LCByte data[], size_t length);
+LCCompare compareIntegerToDouble(int64_t integer, double real);
+LCCompare compareDoubles(double real1, double real2);
+size_t parallelChunkCount(size_t length, size_t minChunkLength);
+void parallelFor(size_t length, size_t minChunkLength, void *cookie, parallelChunkFun fun);
 void writeToFile(LCByte data[], size_t length, char *filePath);
 size_t fileLength(FILE *fd);
 void readFromFile(FILE *fd, LCByte buffer[], size_t length);
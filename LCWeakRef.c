@@ -0,0 +1,143 @@
+#include "LCWeakRef.h"
+
+#define WEAK_REFS_MIN_BUCKETS 64
+
+typedef struct weakRefData* weakRefDataRef;
+
+void weakRefDealloc(LCObjectRef object);
+
+/*
+ - target is NULL once the target was deallocated, tracked is false for targets that never are
+ - weak references to objects that can be deallocated are kept in a side table of buckets chained
+   through next, keyed by the target's address, so deallocating a target finds the references
+   it has to clear without the target knowing about them
+*/
+struct weakRefData {
+  LCObjectRef target;
+  bool tracked;
+  weakRefDataRef next;
+};
+
+struct LCType typeWeakRef = {
+  .name = "LCWeakRef",
+  .immutable = false,
+  .dealloc = weakRefDealloc
+};
+
+LCTypeRef LCTypeWeakRef = &typeWeakRef;
+
+static pthread_mutex_t weakRefsLock = PTHREAD_MUTEX_INITIALIZER;
+static weakRefDataRef *weakRefsBuckets = NULL;
+static size_t weakRefsBucketsLength = 0;
+static size_t weakRefsLength = 0;
+
+static bool weakRefTracked(LCObjectRef target) {
+  return target && !objectIsTaggedInteger(target) && !objectIsImmortal(target);
+}
+
+static size_t weakRefsBucket(LCObjectRef target, size_t bucketsLength) {
+  return ((uintptr_t)target >> 4) & (bucketsLength - 1);
+}
+
+// must be called with weakRefsLock held
+static void weakRefsGrow() {
+  size_t newLength = weakRefsBucketsLength ? weakRefsBucketsLength * 2 : WEAK_REFS_MIN_BUCKETS;
+  weakRefDataRef *newBuckets = calloc(newLength, sizeof(weakRefDataRef));
+  if (!newBuckets) {
+    perror("weakRefsGrow");
+    return;
+  }
+  for (size_t i=0; i<weakRefsBucketsLength; i++) {
+    weakRefDataRef ref = weakRefsBuckets[i];
+    while (ref) {
+      weakRefDataRef next = ref->next;
+      size_t bucket = weakRefsBucket(ref->target, newLength);
+      ref->next = newBuckets[bucket];
+      newBuckets[bucket] = ref;
+      ref = next;
+    }
+  }
+  lcFree(weakRefsBuckets);
+  weakRefsBuckets = newBuckets;
+  weakRefsBucketsLength = newLength;
+}
+
+LCWeakRefRef LCWeakRefCreate(LCObjectRef target) {
+  weakRefDataRef data = malloc(sizeof(struct weakRefData));
+  if (!data) {
+    return NULL;
+  }
+  data->target = target;
+  data->tracked = weakRefTracked(target);
+  data->next = NULL;
+  if (data->tracked) {
+    pthread_mutex_lock(&weakRefsLock);
+    if (weakRefsLength >= weakRefsBucketsLength) {
+      weakRefsGrow();
+    }
+    if (weakRefsBucketsLength == 0) {
+      pthread_mutex_unlock(&weakRefsLock);
+      lcFree(data);
+      return NULL;
+    }
+    size_t bucket = weakRefsBucket(target, weakRefsBucketsLength);
+    data->next = weakRefsBuckets[bucket];
+    weakRefsBuckets[bucket] = data;
+    __atomic_add_fetch(&weakRefsLength, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&weakRefsLock);
+  }
+  return objectCreate(LCTypeWeakRef, data);
+}
+
+// returns the target retained, or NULL if it was deallocated or is being deallocated
+LCObjectRef LCWeakRefCopyTarget(LCWeakRefRef ref) {
+  weakRefDataRef data = objectData(ref);
+  if (!data->tracked) {
+    return data->target;
+  }
+  pthread_mutex_lock(&weakRefsLock);
+  LCObjectRef target = data->target;
+  if (target && !objectRetainIfLive(target)) {
+    target = NULL;
+  }
+  pthread_mutex_unlock(&weakRefsLock);
+  return target;
+}
+
+// must be called with weakRefsLock held, clears every reference to target if ref is NULL
+static void weakRefsRemove(LCObjectRef target, weakRefDataRef ref) {
+  weakRefDataRef *link = &weakRefsBuckets[weakRefsBucket(target, weakRefsBucketsLength)];
+  while (*link) {
+    weakRefDataRef current = *link;
+    if (current->target == target && (!ref || current == ref)) {
+      *link = current->next;
+      current->target = NULL;
+      current->next = NULL;
+      __atomic_sub_fetch(&weakRefsLength, 1, __ATOMIC_RELAXED);
+    } else {
+      link = &current->next;
+    }
+  }
+}
+
+// called when an object is deallocated, before its data goes away
+void weakRefsClear(LCObjectRef object) {
+  if (__atomic_load_n(&weakRefsLength, __ATOMIC_RELAXED) == 0) {
+    return;
+  }
+  pthread_mutex_lock(&weakRefsLock);
+  weakRefsRemove(object, NULL);
+  pthread_mutex_unlock(&weakRefsLock);
+}
+
+void weakRefDealloc(LCObjectRef object) {
+  weakRefDataRef data = objectData(object);
+  if (data->tracked) {
+    pthread_mutex_lock(&weakRefsLock);
+    if (data->target) {
+      weakRefsRemove(data->target, data);
+    }
+    pthread_mutex_unlock(&weakRefsLock);
+  }
+  lcFree(data);
+}
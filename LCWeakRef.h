@@ -0,0 +1,14 @@
+
+#ifndef LivelyC_LCWeakRef_h
+#define LivelyC_LCWeakRef_h
+
+#include "LCCore.h"
+
+typedef LCObjectRef LCWeakRefRef;
+extern LCTypeRef LCTypeWeakRef;
+
+LCWeakRefRef LCWeakRefCreate(LCObjectRef target);
+LCObjectRef LCWeakRefCopyTarget(LCWeakRefRef ref);
+void weakRefsClear(LCObjectRef object);
+
+#endif
@@ -10,4 +10,9 @@
 #include "LCSHA.h"
 #include "LCMemoryStore.h"
 #include "LCFileStore.h"
-#include "LCMutableData.h"
\ No newline at end of file
+#include "LCMutableData.h"
+#include "LCNumber.h"
+#include "LCTypedArray.h"
+#include "LCRecordBatch.h"
+#include "LCIterator.h"
+#include "LCWeakRef.h"
\ No newline at end of file
@@ -0,0 +1,44 @@
+
+#include "LivelyC.h"
+#include <sys/resource.h>
+#include <time.h>
+
+/*
+ builds 200,000 dictionaries with the same 10 keys and looks one key up in each,
+ run it once with and once without the argument "intern" and compare the peak RSS
+*/
+int main(int argc, const char * argv[]) {
+  bool intern = argc > 1 && strcmp(argv[1], "intern") == 0;
+  char *names[] = {"identifier", "timestamp", "username", "description", "category",
+                   "priority", "status", "location", "created", "modified"};
+  size_t count = 200000;
+  LCMutableDictionaryRef *dicts = malloc(sizeof(LCMutableDictionaryRef) * count);
+  if (!dicts) {
+    perror("internBenchmark");
+    return 1;
+  }
+  clock_t start = clock();
+  for (size_t d=0; d<count; d++) {
+    dicts[d] = LCMutableDictionaryCreate(NULL, 0);
+    for (LCInteger k=0; k<10; k++) {
+      LCStringRef key = intern ? LCStringCreateInterned(names[k]) : LCStringCreate(names[k]);
+      LCNumberRef value = LCNumberCreateInteger(k);
+      LCMutableDictionarySetValueForKey(dicts[d], key, value);
+      objectRelease(key);
+      objectRelease(value);
+    }
+  }
+  size_t hits = 0;
+  LCStringRef probe = intern ? LCStringCreateInterned("modified") : LCStringCreate("modified");
+  for (size_t d=0; d<count; d++) {
+    if (LCMutableDictionaryValueForKey(dicts[d], probe)) {
+      hits++;
+    }
+  }
+  double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  printf("%s keys: maxrss %ld KB, %.2f s, %zu hits\n", intern ? "LCStringCreateInterned" : "LCStringCreate",
+         usage.ru_maxrss, seconds, hits);
+  return 0;
+}
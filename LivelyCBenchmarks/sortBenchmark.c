@@ -0,0 +1,98 @@
+
+#include "LivelyC.h"
+#include <time.h>
+
+static double benchmarkSeconds() {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+static int qsortCompare(const void *elem1, const void *elem2) {
+  LCCompare result = objectCompare(*(LCObjectRef*)elem1, *(LCObjectRef*)elem2);
+  if (result == LCEqual) {
+    return 0;
+  }
+  return result == LCGreater ? 1 : -1;
+}
+
+// sorts copies of objects with qsort, objectsSort and objectsSortStable
+static void benchmarkSorts(char *name, LCObjectRef objects[], size_t length) {
+  LCObjectRef *sorted = malloc(sizeof(LCObjectRef) * length);
+  if (!sorted) {
+    perror("benchmarkSorts");
+    return;
+  }
+  memcpy(sorted, objects, sizeof(LCObjectRef) * length);
+  double start = benchmarkSeconds();
+  qsort(sorted, length, sizeof(LCObjectRef), qsortCompare);
+  double qsortSeconds = benchmarkSeconds() - start;
+
+  memcpy(sorted, objects, sizeof(LCObjectRef) * length);
+  start = benchmarkSeconds();
+  objectsSort(sorted, length);
+  double sortSeconds = benchmarkSeconds() - start;
+
+  memcpy(sorted, objects, sizeof(LCObjectRef) * length);
+  start = benchmarkSeconds();
+  objectsSortStable(sorted, length);
+  double stableSeconds = benchmarkSeconds() - start;
+
+  printf("%-22s qsort %.2fs  objectsSort %.2fs  objectsSortStable %.2fs\n", name, qsortSeconds,
+         sortSeconds, stableSeconds);
+  lcFree(sorted);
+}
+
+static void releaseObjects(LCObjectRef objects[], size_t length) {
+  for (size_t i=0; i<length; i++) {
+    objectRelease(objects[i]);
+  }
+}
+
+// sorts 2M objects of each kind, the NULL in the last array sends it down the merge path
+int main(int argc, const char * argv[]) {
+  size_t length = 2000000;
+  LCObjectRef *objects = malloc(sizeof(LCObjectRef) * length);
+  if (!objects) {
+    perror("sortBenchmark");
+    return 1;
+  }
+  char buffer[64];
+  srand(1);
+
+  for (size_t i=0; i<length; i++) {
+    sprintf(buffer, "%08x%08x", rand(), rand());
+    objects[i] = LCStringCreate(buffer);
+  }
+  benchmarkSorts("random strings", objects, length);
+  releaseObjects(objects, length);
+
+  for (size_t i=0; i<length; i++) {
+    sprintf(buffer, "user/profile/%09d", rand() % 1000000);
+    objects[i] = LCStringCreate(buffer);
+  }
+  benchmarkSorts("shared-prefix strings", objects, length);
+  releaseObjects(objects, length);
+
+  for (size_t i=0; i<length; i++) {
+    objects[i] = LCNumberCreateDouble(rand() / 3.0);
+  }
+  benchmarkSorts("doubles", objects, length);
+  releaseObjects(objects, length);
+
+  for (size_t i=0; i<length; i++) {
+    objects[i] = LCNumberCreateInteger(rand());
+  }
+  benchmarkSorts("integers", objects, length);
+  releaseObjects(objects, length);
+
+  objects[0] = NULL;
+  for (size_t i=1; i<length; i++) {
+    objects[i] = i % 2 ? LCNumberCreateInteger(rand()) : LCNumberCreateDouble(rand() / 3.0);
+  }
+  benchmarkSorts("mixed types with NULL", objects, length);
+  releaseObjects(objects, length);
+
+  lcFree(objects);
+  return 0;
+}
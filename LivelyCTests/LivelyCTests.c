@@ -11,10 +11,104 @@ static char* test_retain_counting() {
   mu_assert("retain increases retain count", objectRetainCount(test)==2);
   objectRelease(test);
   mu_assert("releasing decreases retain count", objectRetainCount(test)==1);
+  mu_assert("objects without opt-in state have no extension", test->extension == NULL);
   objectRelease(test);
   return 0;
 }
 
+static char* test_regions() {
+  regionBegin();
+  LCStringRef temporary = objectAutorelease(LCStringCreate("temporary"));
+  LCStringRef escaping = LCStringCreate("escaping");
+  regionBegin();
+  LCStringRef inner = objectAutorelease(objectRetain(escaping));
+  regionEnd();
+  mu_assert("inner region releases its objects", objectRetainCount(escaping)==1 && inner == escaping);
+  mu_assert("autoreleased objects live until the region ends", LCStringEqualCString(temporary, "temporary"));
+  regionEnd();
+  mu_assert("objects escape their region", LCStringEqualCString(escaping, "escaping"));
+  objectRelease(escaping);
+  return 0;
+}
+
+static void* releaseModesViewThread(void *array) {
+  for (LCInteger i=0; i<10000; i++) {
+    objectRelease(LCArrayCreateSubArray(array, 1, 8));
+  }
+  return NULL;
+}
+
+static char* test_release_modes() {
+  LCReleaseMode modes[] = {LCReleaseDeferred, LCReleaseBackground};
+  for (LCInteger m=0; m<2; m++) {
+    releaseSetMode(modes[m]);
+    LCArrayRef chain = LCArrayCreate(NULL, 0);
+    for (LCInteger i=0; i<100000; i++) {
+      LCArrayRef link = LCArrayCreate(&chain, 1);
+      objectRelease(chain);
+      chain = link;
+    }
+    objectRelease(chain);
+    if (modes[m] == LCReleaseDeferred) {
+      mu_assert("deferred release queues the root", releasePending() == 1);
+      mu_assert("releaseDrain is bounded", releaseDrain(10) == 10 && releasePending() == 1);
+      mu_assert("releaseDrain tears down chains iteratively", releaseDrain(0) == 99991 && releasePending() == 0);
+    }
+  }
+  LCStringRef viewed = LCStringCreate("viewed");
+  LCStringRef viewedStrings[] = {viewed, viewed, viewed, viewed, viewed, viewed, viewed, viewed, viewed, viewed};
+  LCArrayRef viewedArray = LCArrayCreate(viewedStrings, 10);
+  objectRelease(viewed);
+  pthread_t viewThreads[4];
+  for (LCInteger i=0; i<4; i++) {
+    pthread_create(&viewThreads[i], NULL, releaseModesViewThread, viewedArray);
+  }
+  for (LCInteger i=0; i<4; i++) {
+    pthread_join(viewThreads[i], NULL);
+  }
+  mu_assert("views share buffers across threads in LCReleaseBackground", objectRetainCount(viewed) == 10 &&
+            LCStringEqualCString(LCArrayObjectAtIndex(viewedArray, 9), "viewed"));
+  objectRelease(viewedArray);
+  releaseSetMode(LCReleaseImmediate);
+  mu_assert("changing the release mode drains the queue", releasePending() == 0);
+  return 0;
+}
+
+static char* test_cycle_collection() {
+  cycleCollectionSetEnabled(true);
+  LCMutableArrayRef first = LCMutableArrayCreate(NULL, 0);
+  LCMutableArrayRef second = LCMutableArrayCreate(NULL, 0);
+  LCMutableArrayAddObject(first, second);
+  LCMutableArrayAddObject(second, first);
+  LCWeakRefRef weakFirst = LCWeakRefCreate(first);
+  LCMutableDictionaryRef dict = LCMutableDictionaryCreate(NULL, 0);
+  LCStringRef key = LCStringCreate("self");
+  LCMutableDictionarySetValueForKey(dict, key, dict);
+  objectRelease(key);
+  LCMutableArrayRef live = LCMutableArrayCreate(NULL, 0);
+  LCMutableArrayAddObject(live, live);
+  objectRelease(objectRetain(live));
+  objectRelease(first);
+  objectRelease(second);
+  objectRelease(dict);
+  
+  LCObjectRef target = LCWeakRefCopyTarget(weakFirst);
+  mu_assert("weak references see uncollected cycles", target == first);
+  objectRelease(target);
+  size_t pending = cycleRootsPending();
+  size_t freed = cycleCollect(1);
+  mu_assert("cycleCollect bounds the roots it examines", pending > 1 && cycleRootsPending() >= pending - 1);
+  freed = freed + cycleCollect(0);
+  mu_assert("cycleCollect frees unreachable cycles only", freed == 6 && cycleRootsPending() == 0 &&
+            objectRetainCount(live) == 2 && LCMutableArrayObjectAtIndex(live, 0) == live);
+  mu_assert("weak references are cleared", LCWeakRefCopyTarget(weakFirst) == NULL);
+  objectRelease(weakFirst);
+  LCMutableArrayRemoveIndex(live, 0);
+  objectRelease(live);
+  cycleCollectionSetEnabled(false);
+  return 0;
+}
+
 static char* test_pipe() {
   LCPipeRef stream = LCPipeCreate();
   FILE* fd = LCPipeWriteFile(stream);
@@ -42,6 +136,31 @@ static char* test_memory_stream() {
 }
 
 
+LCStaticString(staticKey, "key");
+LCStaticString(staticOther, "other");
+LCStaticArray(staticKeys, LCStaticRef(staticKey), LCStaticRef(staticOther));
+
+static char* test_static_objects() {
+  mu_assert("LCStaticString", LCStringEqualCString(staticKey, "key") && LCStringLength(staticOther) == 5 &&
+            objectEqual(staticKey, LCStringCreate("key")));
+  objectRetain(staticKey);
+  objectRelease(staticKey);
+  objectRelease(staticKey);
+  mu_assert("static objects are immortal", objectIsImmortal(staticKey) &&
+            objectRetainCount(staticKey) == LC_IMMORTAL_RETAIN_COUNT);
+  
+  char staticHash[HASH_LENGTH];
+  char hash[HASH_LENGTH];
+  objectHash(staticKeys, staticHash);
+  LCStringRef keys[] = {LCStringCreate("key"), LCStringCreate("other")};
+  objectHash(LCArrayCreate(keys, 2), hash);
+  mu_assert("LCStaticArray", LCArrayLength(staticKeys) == 2 && LCArrayObjectAtIndex(staticKeys, 1) == staticOther &&
+            strcmp(staticHash, hash) == 0);
+  objectHash(staticKeys, staticHash);
+  mu_assert("static digest is kept", strcmp(staticHash, hash) == 0);
+  return 0;
+}
+
 static char* test_string() {
   char* aCString = "abcd";
   char* anIdenticalCString = "abcd";
@@ -82,6 +201,67 @@ static char* test_string() {
   
   LCStringRef concatDelim = LCStringCreateFromStringArrayWithDelim(stringArr, 2, "/");
   mu_assert("LCStringCreateFromStringArrayWithDelim", LCStringEqualCString(concatDelim, "abcd/abcd"));
+  
+  char binaryChars[] = {'a', '\0', 'b'};
+  LCStringRef binary = LCStringCreateFromChars(binaryChars, 3);
+  LCStringRef binaryPrefix = LCStringCreateFromChars(binaryChars, 1);
+  mu_assert("binary safe LCString", LCStringLength(binary) == 3 && !LCStringEqual(binary, binaryPrefix) &&
+            objectCompare(binaryPrefix, binary) == LCSmaller && LCStringEqualCString(binaryPrefix, "a") &&
+            !LCStringEqualCString(binary, "a"));
+  mu_assert("LCStringHashValue", LCStringHashValue(aLCString) == LCStringHashValue(anIdenticalLCString) &&
+            LCStringHashValue(aLCString) != LCStringHashValue(string3));
+  
+  LCStringRef slice = LCStringCreateSlice(tokenString, 3, 5);
+  LCStringRef sliceOfSlice = LCStringCreateSlice(slice, 0, 2);
+  mu_assert("LCStringCreateSlice", LCStringEqualCString(slice, "cd/ef") && LCStringEqualCString(sliceOfSlice, "cd") &&
+            LCStringChars(slice) == LCStringChars(tokenString) + 3 && strcmp(LCStringChars(sliceOfSlice), "cd") == 0 &&
+            LCStringLength(LCStringCreateSlice(tokenString, 6, 10)) == 2);
+  mu_assert("tokens share the parent buffer", LCStringChars(tokens[2]) == LCStringChars(tokenString) + 6);
+  char sliceBuffer[3];
+  mu_assert("LCStringGetCString", LCStringGetCString(sliceOfSlice, sliceBuffer, 3) && strcmp(sliceBuffer, "cd") == 0 &&
+            !LCStringGetCString(slice, sliceBuffer, 3) && LCStringChars(sliceOfSlice) == LCStringChars(sliceOfSlice));
+  
+  LCMutableStringRef mString = LCMutableStringCreate("ab");
+  LCMutableStringAppend(mString, "cd");
+  LCMutableStringAppendString(mString, sliceOfSlice);
+  for (LCInteger i=0; i<100; i++) {
+    LCMutableStringAppendf(mString, "/%d", i);
+  }
+  mu_assert("LCMutableStringAppendf", LCMutableStringLength(mString) == 6 + 290 &&
+            strncmp(LCMutableStringChars(mString), "abcdcd/0/1/2", 12) == 0 &&
+            strcmp(LCMutableStringChars(mString) + LCMutableStringLength(mString) - 3, "/99") == 0);
+  LCStringRef built = LCMutableStringCreateString(mString);
+  mu_assert("LCMutableStringCreateString", LCStringLength(built) == 296 && LCMutableStringLength(mString) == 0 &&
+            strcmp(LCMutableStringChars(mString), "") == 0 && strncmp(LCStringChars(built), "abcdcd/0", 8) == 0);
+  LCMutableStringAppend(mString, "x");
+  mu_assert("LCMutableString reuse", LCStringEqualCString(LCMutableStringCreateString(mString), "x"));
+  LCMutableStringAppend(mString, "yz");
+  LCStringRef mutableSlice = LCStringCreateSlice(mString, 0, 2);
+  LCStringRef yz = LCStringCreate("yz");
+  mu_assert("LCString functions on LCMutableString", LCStringLength(mString) == 2 &&
+            strcmp(LCStringChars(mString), "yz") == 0 && LCStringEqualCString(mString, "yz") &&
+            LCStringEqual(mutableSlice, yz) && LCStringHashValue(mutableSlice) == LCStringHashValue(yz));
+  LCMutableStringAppend(mString, "!");
+  mu_assert("LCMutableString slices are copies", LCStringEqualCString(mutableSlice, "yz") &&
+            LCStringHashValue(mString) != LCStringHashValue(mutableSlice));
+  objectRelease(yz);
+  objectRelease(mutableSlice);
+  
+  LCStringRef interned1 = LCStringCreateInterned("interned");
+  LCStringRef interned2 = LCStringCreateInternedFromChars("interned!", 8);
+  LCStringRef interned3 = LCStringCreateInterned("other");
+  LCStringRef notInterned = LCStringCreate("interned");
+  mu_assert("LCStringCreateInterned", interned1 == interned2 && LCStringIsInterned(interned1) &&
+            !LCStringIsInterned(notInterned) && !objectEqual(interned1, interned3) &&
+            objectEqual(interned1, notInterned) && objectCompare(interned3, interned1) == LCGreater);
+  objectRelease(interned1);
+  mu_assert("interned strings are immortal", objectIsImmortal(interned1) && LCStringEqualCString(interned1, "interned") &&
+            LCStringCreateInterned("interned") == interned2);
+  
+  LCArrayRef emptyTokens = LCStringCreateTokens(LCStringCreate("/a/"), '/');
+  mu_assert("LCStringCreateTokens keeps empty tokens", LCArrayLength(emptyTokens) == 3 &&
+            LCStringLength(LCArrayObjectAtIndex(emptyTokens, 0)) == 0 &&
+            LCStringEqualCString(LCArrayObjectAtIndex(emptyTokens, 1), "a"));
   return 0;
 }
 
@@ -130,6 +310,50 @@ static char* test_array() {
   mu_assert("LCMutableArrayAddObject 50 times", (LCMutableArrayObjectAtIndex(mArray, 50) == string4) &&
             (LCMutableArrayObjectAtIndex(mArray, 1) == string2));
   
+  LCMutableArrayRef growArray = LCMutableArrayCreate(NULL, 0);
+  for (LCInteger i=0; i<6; i++) {
+    LCMutableArrayAddObject(growArray, stringArray[i%3]);
+  }
+  mu_assert("LCMutableArray grows past inline storage", LCMutableArrayLength(growArray) == 6 &&
+            LCMutableArrayObjectAtIndex(growArray, 2) == string3 && LCMutableArrayObjectAtIndex(growArray, 5) == string3);
+  objectRelease(growArray);
+  
+  LCInteger retainCount = objectRetainCount(string4);
+  LCMutableArrayRef copiedArray = LCMutableArrayCopy(mArray);
+  LCArrayRef frozenArray = LCMutableArrayCreateArray(mArray);
+  mu_assert("copies share the buffer", objectRetainCount(string4) == retainCount &&
+            LCArrayObjects(frozenArray) == LCMutableArrayObjects(mArray));
+  LCMutableArrayRemoveIndex(copiedArray, 0);
+  LCMutableArrayAddObject(mArray, string1);
+  mu_assert("copy on write", LCMutableArrayLength(copiedArray) == 53 && LCMutableArrayLength(mArray) == 55 &&
+            LCArrayLength(frozenArray) == 54 && LCMutableArrayObjectAtIndex(copiedArray, 0) == string2 &&
+            LCArrayObjectAtIndex(frozenArray, 0) == string1 && LCMutableArrayObjectAtIndex(mArray, 54) == string1);
+  LCArrayRef window = LCArrayCreateSubArray(frozenArray, 50, 10);
+  LCArrayRef windowCopy = LCArrayCreate(LCArrayObjects(window), LCArrayLength(window));
+  mu_assert("LCArrayCreateSubArray view", LCArrayLength(window) == 4 &&
+            LCArrayObjects(window) == LCArrayObjects(frozenArray) + 50 && objectCompare(window, windowCopy) == LCEqual &&
+            objectHashEqual(window, windowCopy));
+  LCMutableArrayRef windowMutable = LCMutableArrayCreateFromArray(window);
+  objectRelease(window);
+  LCMutableArrayAddObject(windowMutable, string1);
+  mu_assert("mutable copy of a view", LCMutableArrayLength(windowMutable) == 5 &&
+            LCArrayLength(frozenArray) == 54 && LCMutableArrayObjectAtIndex(windowMutable, 4) == string1);
+  objectRelease(windowMutable);
+  objectRelease(windowCopy);
+  objectRelease(copiedArray);
+  objectRelease(frozenArray);
+  LCMutableArrayRemoveIndex(mArray, 54);
+  
+  LCMutableArrayRef bulkArray = LCMutableArrayCreate(stringArray, 2);
+  LCMutableArrayAddObjects(bulkArray, stringArray, 3);
+  LCMutableArrayInsertObjects(bulkArray, 1, stringArray, 3);
+  LCInteger removeIndices[] = {7, 0, 3, 7};
+  LCMutableArrayRemoveIndices(bulkArray, removeIndices, 4);
+  LCStringRef* bulk = LCMutableArrayObjects(bulkArray);
+  mu_assert("bulk LCMutableArray mutation", LCMutableArrayLength(bulkArray) == 5 && bulk[0] == string1 &&
+            bulk[1] == string2 && bulk[2] == string2 && bulk[3] == string1 && bulk[4] == string2);
+  objectRelease(bulkArray);
+  
   LCMutableArrayRemoveIndex(mArray, 1);
   mu_assert("LCMutableArrayRemoveIndex1", (LCMutableArrayObjectAtIndex(mArray, 0)==string1) &&
             (LCMutableArrayObjectAtIndex(mArray, 1)==string3) &&
@@ -146,6 +370,20 @@ static char* test_array() {
   LCStringRef* sorted = LCMutableArrayObjects(sortArray);
   mu_assert("LCMutableArraySort", (sorted[0] == string1) && (sorted[1] == string2) && (sorted[2] == string3));
   
+  LCStringRef prefixB = LCStringCreate("common prefix b");
+  LCStringRef prefixA1 = LCStringCreate("common prefix a");
+  LCStringRef prefixA2 = LCStringCreate("common prefix a");
+  LCStringRef stableStrings[] = {prefixB, prefixA1, prefixA2, string1};
+  LCMutableArrayRef stableArray = LCMutableArrayCreate(stableStrings, 4);
+  LCMutableArraySortStable(stableArray);
+  sorted = LCMutableArrayObjects(stableArray);
+  mu_assert("LCMutableArraySortStable", sorted[0] == string1 && sorted[1] == prefixA1 && sorted[2] == prefixA2 &&
+            sorted[3] == prefixB);
+  objectRelease(stableArray);
+  objectRelease(prefixB);
+  objectRelease(prefixA1);
+  objectRelease(prefixA2);
+  
   LCArrayRef arrays[] = {array, array};
   LCArrayRef mergedArray = LCArrayCreateFromArrays(arrays, 2);
   mu_assert("LCArrayCreateFromArrays", LCArrayLength(mergedArray)==2*LCArrayLength(array));
@@ -166,6 +404,146 @@ static char* test_array() {
   return 0;
 }
 
+static LCObjectRef parallelDouble(LCInteger i, void* info, LCObjectRef each) {
+  return LCNumberCreateInteger(LCNumberInteger(each) * 2);
+}
+
+static bool parallelMultipleOfThree(LCInteger i, void* info, LCObjectRef each) {
+  return LCNumberInteger(each) % 3 == 0;
+}
+
+static void parallelSum(LCInteger i, void* info, void *accumulator, LCObjectRef each) {
+  *(int64_t*)accumulator = *(int64_t*)accumulator + LCNumberInteger(each);
+}
+
+static void parallelSumCombine(void* info, void *accumulator, void *other) {
+  *(int64_t*)accumulator = *(int64_t*)accumulator + *(int64_t*)other;
+}
+
+static char* test_parallel_array() {
+  size_t length = 100000;
+  LCObjectRef *numbers = malloc(sizeof(LCObjectRef) * length);
+  for (LCInteger i=0; i<length; i++) {
+    numbers[i] = LCNumberCreateInteger(i);
+  }
+  LCArrayRef array = LCArrayCreate(numbers, length);
+  free(numbers);
+  
+  LCArrayRef doubled = LCArrayCreateArrayWithParallelMap(array, NULL, parallelDouble);
+  mu_assert("LCArrayCreateArrayWithParallelMap", LCArrayLength(doubled) == length &&
+            LCNumberInteger(LCArrayObjectAtIndex(doubled, 0)) == 0 &&
+            LCNumberInteger(LCArrayObjectAtIndex(doubled, 77777)) == 155554 &&
+            LCNumberInteger(LCArrayObjectAtIndex(doubled, length-1)) == (length-1)*2);
+  
+  LCArrayRef filtered = LCArrayCreateArrayWithParallelFilter(array, NULL, parallelMultipleOfThree);
+  mu_assert("LCArrayCreateArrayWithParallelFilter", LCArrayLength(filtered) == 33334 &&
+            LCNumberInteger(LCArrayObjectAtIndex(filtered, 1)) == 3 &&
+            LCNumberInteger(LCArrayObjectAtIndex(filtered, 33333)) == 99999);
+  
+  int64_t sum = 0;
+  LCArrayParallelReduce(array, NULL, &sum, sizeof(int64_t), parallelSum, parallelSumCombine);
+  mu_assert("LCArrayParallelReduce", sum == (int64_t)length*(length-1)/2);
+  
+  LCMutableArrayRef shuffled = LCMutableArrayCreate(NULL, 0);
+  for (LCInteger i=0; i<length; i++) {
+    LCMutableArrayAddObject(shuffled, LCArrayObjectAtIndex(array, (i * 7919) % length));
+  }
+  LCMutableArraySort(shuffled);
+  bool ordered = true;
+  for (LCInteger i=0; i<length && ordered; i++) {
+    ordered = LCNumberInteger(LCMutableArrayObjectAtIndex(shuffled, i)) == i;
+  }
+  mu_assert("LCMutableArraySort by sort key", ordered);
+  
+  LCMutableArrayRef prefixed = LCMutableArrayCreate(NULL, 0);
+  for (LCInteger i=0; i<1000; i++) {
+    char buffer[64];
+    sprintf(buffer, "a prefix longer than one sort key %05ld", (long)((i * 7919) % 1000));
+    LCStringRef string = LCStringCreate(buffer);
+    LCMutableArrayAddObject(prefixed, string);
+    objectRelease(string);
+  }
+  LCMutableArraySortStable(prefixed);
+  ordered = true;
+  for (LCInteger i=1; i<1000 && ordered; i++) {
+    ordered = objectCompare(LCMutableArrayObjectAtIndex(prefixed, i-1), LCMutableArrayObjectAtIndex(prefixed, i)) == LCSmaller;
+  }
+  mu_assert("LCMutableArraySortStable by sort key levels", ordered);
+  objectRelease(prefixed);
+  
+  LCMutableArrayRef mixed = LCMutableArrayCreate(NULL, 0);
+  for (LCInteger i=0; i<length; i++) {
+    LCMutableArrayAddObject(mixed, LCArrayObjectAtIndex(doubled, (i * 7919) % length));
+    LCMutableArrayAddObject(mixed, LCArrayObjectAtIndex(array, (i * 7919) % length));
+  }
+  LCMutableArrayAddObject(mixed, NULL);
+  LCMutableArraySortStable(mixed);
+  ordered = LCMutableArrayObjectAtIndex(mixed, 0) == NULL;
+  for (LCInteger i=2; i<=length*2 && ordered; i++) {
+    ordered = objectCompare(LCMutableArrayObjectAtIndex(mixed, i-1), LCMutableArrayObjectAtIndex(mixed, i)) != LCGreater;
+  }
+  mu_assert("LCMutableArraySortStable merge sort", ordered);
+  objectRelease(shuffled);
+  objectRelease(mixed);
+  objectRelease(array);
+  objectRelease(doubled);
+  objectRelease(filtered);
+  return 0;
+}
+
+static LCObjectRef iteratorRepeat(LCInteger i, void* info, LCObjectRef each) {
+  LCObjectRef objects[] = {each, each};
+  return LCArrayCreate(objects, 2);
+}
+
+static char* test_iterator() {
+  LCObjectRef numbers[10];
+  for (LCInteger i=0; i<10; i++) {
+    numbers[i] = LCNumberCreateInteger(i);
+  }
+  LCArrayRef array = LCArrayCreate(numbers, 10);
+  for (LCInteger i=0; i<10; i++) {
+    objectRelease(numbers[i]);
+  }
+  
+  LCIteratorRef source = LCIteratorCreateFromArray(array);
+  LCIteratorRef filtered = LCIteratorCreateFilter(source, NULL, parallelMultipleOfThree);
+  LCIteratorRef doubled = LCIteratorCreateMap(filtered, NULL, parallelDouble);
+  LCIteratorRef skipped = LCIteratorCreateSkip(doubled, 1);
+  LCIteratorRef taken = LCIteratorCreateTake(skipped, 2);
+  objectRelease(source);
+  objectRelease(filtered);
+  objectRelease(doubled);
+  objectRelease(skipped);
+  LCArrayRef collected = LCIteratorCreateArray(taken);
+  mu_assert("LCIterator pipeline", LCArrayLength(collected) == 2 &&
+            LCNumberInteger(LCArrayObjectAtIndex(collected, 0)) == 6 &&
+            LCNumberInteger(LCArrayObjectAtIndex(collected, 1)) == 12);
+  mu_assert("LCIterator exhausted", LCIteratorNext(taken) == NULL);
+  objectRelease(taken);
+  objectRelease(collected);
+  
+  source = LCIteratorCreateFromChildren(array, "objects");
+  LCIteratorRef repeated = LCIteratorCreateFlatMap(source, NULL, iteratorRepeat);
+  objectRelease(source);
+  int64_t sum = 0;
+  LCIteratorReduce(repeated, NULL, &sum, parallelSum);
+  mu_assert("LCIteratorCreateFlatMap", sum == 90);
+  objectRelease(repeated);
+  
+  LCStringRef key = LCStringCreate("key");
+  LCKeyValueRef keyValue = LCKeyValueCreate(key, array);
+  source = LCIteratorCreateFromChildren(keyValue, "value");
+  objectRelease(keyValue);
+  LCObjectRef child = LCIteratorNext(source);
+  mu_assert("LCIteratorCreateFromChildren copies the children", child == array && LCIteratorNext(source) == NULL);
+  objectRelease(child);
+  objectRelease(source);
+  objectRelease(key);
+  objectRelease(array);
+  return 0;
+}
+
 static char* test_dictionary() {
   LCStringRef string1 = LCStringCreate("abc");
   LCStringRef string2 = LCStringCreate("def");
@@ -187,6 +565,243 @@ static char* test_dictionary() {
   
   LCMutableDictionarySetValueForKey(dict, string1c, string1);
   mu_assert("LCMutableDictionarySetValueForKey", LCMutableDictionaryValueForKey(dict, string1) == string1);
+  
+  LCMutableDictionarySetValueForKey(dict, LCStringCreateInterned("key"), string2);
+  mu_assert("LCMutableDictionaryValueForCString", LCMutableDictionaryValueForCString(dict, "abc") == string1 &&
+            LCKeyValueValue(LCMutableDictionaryEntryForCString(dict, "ghi")) == string1 &&
+            LCMutableDictionaryValueForCString(dict, "ab") == NULL);
+  
+  char borrowed[] = "key";
+  LCStackString(stackKey, borrowed);
+  mu_assert("LCStackString", LCStringLength(stackKey) == 3 && objectEqual(stackKey, LCStringCreate("key")) &&
+            objectIsImmortal(stackKey));
+  
+  LCKeyValueRef upserts[] = {LCKeyValueCreate(string2c, string3), LCKeyValueCreate(string1c, string3),
+    LCKeyValueCreate(string2, string1), LCKeyValueCreate(LCNumberCreateInteger(1), string2)};
+  LCMutableDictionaryRef bulkDict = LCMutableDictionaryCopy(dict);
+  size_t bulkLength = LCMutableDictionaryLength(bulkDict);
+  LCMutableDictionaryAddEntries(bulkDict, upserts, 4);
+  mu_assert("LCMutableDictionaryAddEntries", LCMutableDictionaryLength(bulkDict) == bulkLength + 2 &&
+            LCMutableDictionaryValueForKey(bulkDict, string1) == string3 &&
+            LCMutableDictionaryValueForKey(bulkDict, string2) == string1 &&
+            LCMutableDictionaryValueForKey(bulkDict, LCNumberCreateInteger(1)) == string2 &&
+            LCMutableDictionaryValueForKey(dict, string1) == string1);
+  LCMutableStringRef mutableKey = LCMutableStringCreate("ghi");
+  LCKeyValueRef mutableUpsert = LCKeyValueCreate(mutableKey, string1);
+  bulkLength = LCMutableDictionaryLength(bulkDict);
+  LCMutableDictionaryAddEntries(bulkDict, &mutableUpsert, 1);
+  mu_assert("LCMutableDictionaryAddEntries matches keys like objectEqual",
+            LCMutableDictionaryLength(bulkDict) == bulkLength && objectEqual(mutableKey, string3) &&
+            LCMutableDictionaryValueForKey(bulkDict, string3) == string1);
+  objectRelease(mutableUpsert);
+  objectRelease(mutableKey);
+  
+  LCMutableDictionaryRef dictCopy = LCMutableDictionaryCopy(dict);
+  LCMutableDictionaryDeleteKey(dictCopy, string1);
+  mu_assert("LCMutableDictionaryCopy", LCMutableDictionaryValueForKey(dictCopy, string1) == NULL &&
+            LCMutableDictionaryValueForKey(dict, string1) == string1);
+  
+  LCMutableDictionaryRef numberDict = LCMutableDictionaryCreate(NULL, 0);
+  LCMutableDictionarySetValueForKey(numberDict, LCNumberCreateInteger(1), string1);
+  LCStringRef missing = LCStringCreate("zzz");
+  mu_assert("keys of other types", LCMutableDictionaryValueForKey(numberDict, missing) == NULL &&
+            !objectEqual(missing, LCNumberCreateInteger(1)) && !objectEqual(LCNumberCreateInteger(1), missing) &&
+            objectCompare(missing, LCNumberCreateInteger(1)) != objectCompare(LCNumberCreateInteger(1), missing));
+  objectRelease(missing);
+  objectRelease(numberDict);
+  
+  mu_assert("interned dictionary keys", LCMutableDictionaryValueForKey(dict, LCStringCreateInterned("key")) == string2 &&
+            LCMutableDictionaryValueForKey(dict, LCStringCreate("key")) == string2);
+  return 0;
+}
+
+static char* test_number() {
+  LCNumberRef small = LCNumberCreateInteger(42);
+  LCNumberRef sameSmall = LCNumberCreateInteger(42);
+  mu_assert("small integers are tagged", small == sameSmall && objectIsTaggedInteger(small) &&
+            objectType(small) == LCTypeNumber && LCNumberInteger(small) == 42);
+  mu_assert("tagged integers skip refcounting", objectRetain(small) == small && objectRelease(small) == small &&
+            objectData(small) == NULL);
+  
+  LCNumberRef negative = LCNumberCreateInteger(-7);
+  LCNumberRef large = LCNumberCreateInteger(INT64_MAX);
+  LCNumberRef real = LCNumberCreateDouble(41.5);
+  mu_assert("large integers are boxed", !objectIsTaggedInteger(large) && LCNumberInteger(large) == INT64_MAX &&
+            LCNumberInteger(negative) == -7);
+  mu_assert("LCNumber compare", objectCompare(real, small) == LCSmaller && objectCompare(small, large) == LCSmaller &&
+            objectCompare(negative, real) == LCSmaller && objectCompare(LCNumberCreateDouble(42.0), small) == LCEqual);
+  
+  LCNumberRef largeReal = LCNumberCreateDouble(9.223372036854775807e18);
+  LCNumberRef belowLargeReal = LCNumberCreateInteger(INT64_MAX - 1024);
+  LCNumberRef notANumber = LCNumberCreateDouble(NAN);
+  LCNumberRef infinity = LCNumberCreateDouble(INFINITY);
+  mu_assert("LCNumber compares integers and doubles exactly",
+            objectCompare(large, largeReal) == LCSmaller && !objectEqual(large, largeReal) &&
+            objectCompare(largeReal, belowLargeReal) == LCGreater &&
+            objectCompare(LCNumberCreateInteger(-3), LCNumberCreateDouble(-2.5)) == LCSmaller &&
+            objectCompare(LCNumberCreateDouble(-3.5), LCNumberCreateInteger(-3)) == LCSmaller);
+  mu_assert("LCNumber orders NaN after every number", objectCompare(notANumber, infinity) == LCGreater &&
+            objectCompare(large, notANumber) == LCSmaller && objectCompare(notANumber, real) == LCGreater &&
+            objectEqual(notANumber, LCNumberCreateDouble(-NAN)) && !objectEqual(notANumber, small));
+  LCNumberRef extremes[] = {notANumber, largeReal, infinity, large, LCNumberCreateDouble(-NAN)};
+  objectsSort(extremes, 5);
+  mu_assert("LCNumber sort keys agree with compare", extremes[0] == large && extremes[1] == largeReal &&
+            extremes[2] == infinity && isnan(LCNumberDouble(extremes[3])) && isnan(LCNumberDouble(extremes[4])));
+  
+  LCNumberRef numbers[] = {large, real, small, negative};
+  objectsSort(numbers, 4);
+  mu_assert("LCNumber objectsSort", numbers[0] == negative && numbers[1] == real && numbers[2] == small &&
+            numbers[3] == large);
+  
+  LCMemoryStoreRef store = LCMemoryStoreCreate();
+  LCContextRef context = contextCreate(LCMemoryStoreStoreObject(store), NULL, 0);
+  LCNumberRef storedNumbers[] = {negative, large, real};
+  LCArrayRef array = LCArrayCreate(storedNumbers, 3);
+  objectStore(array, context);
+  char hash[HASH_LENGTH];
+  objectHash(array, hash);
+  LCArrayRef storedArray = objectCreateFromContext(context, LCTypeArray, hash);
+  mu_assert("LCNumber persistence", LCNumberInteger(LCArrayObjectAtIndex(storedArray, 0)) == -7 &&
+            LCNumberInteger(LCArrayObjectAtIndex(storedArray, 1)) == INT64_MAX &&
+            LCNumberIsDouble(LCArrayObjectAtIndex(storedArray, 2)) &&
+            LCNumberDouble(LCArrayObjectAtIndex(storedArray, 2)) == 41.5);
+  return 0;
+}
+
+static char* test_typed_array() {
+  int32_t integers[] = {5, -3, 12, 7, 0, -20, 9, 1, 4};
+  LCTypedArrayRef intArray = LCTypedArrayCreate(LCElementInt32, integers, 9);
+  mu_assert("LCTypedArray reductions", LCTypedArrayLength(intArray) == 9 && LCTypedArraySum(intArray) == 15 &&
+            LCTypedArrayMin(intArray) == -20 && LCTypedArrayMax(intArray) == 12);
+  
+  LCTypedArrayRef sortedInts = LCTypedArrayCreateSorted(intArray);
+  int32_t *sortedIntValues = LCTypedArrayValues(sortedInts);
+  bool intsSorted = true;
+  for (LCInteger i=1; i<9; i++) {
+    intsSorted = intsSorted && sortedIntValues[i-1] <= sortedIntValues[i];
+  }
+  mu_assert("LCTypedArrayCreateSorted int32", intsSorted && sortedIntValues[0] == -20 && sortedIntValues[8] == 12);
+  
+  double reals[] = {1.5, -2.25, 0.0, 3.0, -0.5};
+  double weights[] = {2.0, 1.0, 4.0, 1.0, 2.0};
+  LCTypedArrayRef realArray = LCTypedArrayCreate(LCElementDouble, reals, 5);
+  LCTypedArrayRef weightArray = LCTypedArrayCreate(LCElementDouble, weights, 5);
+  mu_assert("LCTypedArrayDot", LCTypedArrayDot(realArray, weightArray) == 2.75);
+  LCTypedArrayRef sortedReals = LCTypedArrayCreateSorted(realArray);
+  mu_assert("LCTypedArrayCreateSorted double", LCTypedArrayValueAtIndex(sortedReals, 0) == -2.25 &&
+            LCTypedArrayValueAtIndex(sortedReals, 1) == -0.5 && LCTypedArrayValueAtIndex(sortedReals, 4) == 3.0);
+  
+  float floats[] = {0.5f, -1.5f, 2.5f};
+  LCTypedArrayRef floatArray = LCTypedArrayCreate(LCElementFloat, floats, 3);
+  LCTypedArrayRef sortedFloats = LCTypedArrayCreateSorted(floatArray);
+  mu_assert("LCTypedArray float", LCTypedArraySum(floatArray) == 1.5 &&
+            LCTypedArrayValueAtIndex(sortedFloats, 0) == -1.5f && LCTypedArrayValueAtIndex(sortedFloats, 2) == 2.5f);
+  
+  int64_t bigIntegers1[] = {INT64_MAX, INT64_MAX};
+  int64_t bigIntegers2[] = {INT64_MAX, INT64_MAX - 1};
+  LCTypedArrayRef bigArray1 = LCTypedArrayCreate(LCElementInt64, bigIntegers1, 2);
+  LCTypedArrayRef bigArray2 = LCTypedArrayCreate(LCElementInt64, bigIntegers2, 2);
+  double withNaN[] = {NAN, 1.0};
+  double withoutNaN[] = {INFINITY, 1.0};
+  LCTypedArrayRef nanArray = LCTypedArrayCreate(LCElementDouble, withNaN, 2);
+  LCTypedArrayRef infinityArray = LCTypedArrayCreate(LCElementDouble, withoutNaN, 2);
+  LCTypedArrayRef sameNanArray = LCTypedArrayCreate(LCElementDouble, withNaN, 2);
+  mu_assert("LCTypedArray compares elements in their own type", objectCompare(bigArray1, bigArray2) == LCGreater &&
+            objectCompare(nanArray, infinityArray) == LCGreater && objectCompare(infinityArray, nanArray) == LCSmaller &&
+            objectCompare(nanArray, sameNanArray) == LCEqual);
+  mu_assert("LCTypedArray int64 sums don't overflow", LCTypedArraySum(bigArray1) == 2.0 * (double)INT64_MAX &&
+            LCTypedArrayDot(bigArray1, bigArray1) > 0);
+  objectRelease(bigArray1);
+  objectRelease(bigArray2);
+  objectRelease(nanArray);
+  objectRelease(infinityArray);
+  objectRelease(sameNanArray);
+  
+  uint32_t headers[][4] = {
+    {LCElementDouble, 0, 2, 0},
+    {LCElementDouble, 0, 3, 0},
+    {42, 0, 2, 0},
+    {LCElementInt32, 0, 0, 0x80000000}
+  };
+  LCInteger validLengths[] = {2, 0, 0, 0};
+  for (LCInteger i=0; i<4; i++) {
+    FILE *fd = tmpfile();
+    fwrite(headers[i], sizeof(headers[i]), 1, fd);
+    fwrite(reals, sizeof(double), 2, fd);
+    rewind(fd);
+    LCTypedArrayRef fileArray = objectCreateFromFile(NULL, LCTypeTypedArray, fd);
+    fclose(fd);
+    mu_assert("typed array headers are checked against the file", LCTypedArrayLength(fileArray) == validLengths[i] &&
+              LCTypedArrayIsMapped(fileArray) == (i == 0));
+    objectRelease(fileArray);
+  }
+  return 0;
+}
+
+static char* test_record_batch() {
+  LCStringRef nameKey = LCStringCreate("name");
+  LCStringRef ageKey = LCStringCreate("age");
+  LCStringRef scoreKey = LCStringCreate("score");
+  char *names[] = {"anna", "bob", "anna", "carl"};
+  LCMutableArrayRef records = LCMutableArrayCreate(NULL, 0);
+  for (LCInteger i=0; i<4; i++) {
+    LCMutableDictionaryRef record = LCMutableDictionaryCreate(NULL, 0);
+    LCStringRef name = LCStringCreate(names[i]);
+    LCNumberRef age = LCNumberCreateInteger(20 + i*10);
+    LCMutableDictionarySetValueForKey(record, nameKey, name);
+    LCMutableDictionarySetValueForKey(record, ageKey, age);
+    if (i != 2) {
+      LCNumberRef score = LCNumberCreateDouble(i * 0.5);
+      LCMutableDictionarySetValueForKey(record, scoreKey, score);
+      objectRelease(score);
+    }
+    LCMutableArrayAddObject(records, record);
+    objectRelease(name);
+    objectRelease(record);
+  }
+  LCStringRef fields[] = {nameKey, ageKey, scoreKey};
+  LCRecordBatchRef batch = LCRecordBatchCreateFromDictionaries(records, fields, 3);
+  mu_assert("LCRecordBatchCreateFromDictionaries", LCRecordBatchLength(batch) == 4 &&
+            LCRecordBatchColumnCount(batch) == 3 && LCRecordBatchColumnIndex(batch, ageKey) == 1 &&
+            LCRecordBatchColumnType(batch, 0) == LCColumnString && LCRecordBatchColumnType(batch, 1) == LCColumnInteger &&
+            LCRecordBatchColumnType(batch, 2) == LCColumnDouble);
+  
+  int32_t *codes = LCRecordBatchStringCodes(batch, 0);
+  mu_assert("LCRecordBatch dictionary encoding", LCArrayLength(LCRecordBatchStringDictionary(batch, 0)) == 3 &&
+            codes[0] == codes[2] && codes[0] != codes[1]);
+  mu_assert("LCRecordBatch missing values", isnan(LCRecordBatchDoubleColumn(batch, 2)[2]) &&
+            LCRecordBatchIntegerColumn(batch, 1)[3] == 50);
+  
+  size_t rows[4];
+  LCStringRef anna = LCStringCreate("anna");
+  mu_assert("LCRecordBatchFilterString", LCRecordBatchFilterString(batch, 0, anna, rows) == 2 &&
+            rows[0] == 0 && rows[1] == 2);
+  mu_assert("LCRecordBatchFilterRange", LCRecordBatchFilterRange(batch, 1, 25, 45, rows) == 2 &&
+            rows[0] == 1 && rows[1] == 2);
+  
+  LCMemoryStoreRef store = LCMemoryStoreCreate();
+  LCContextRef context = contextCreate(LCMemoryStoreStoreObject(store), NULL, 0);
+  objectStore(batch, context);
+  char hash[HASH_LENGTH];
+  objectHash(batch, hash);
+  LCRecordBatchRef storedBatch = LCRecordBatchCreateFromHash(context, hash);
+  mu_assert("LCRecordBatch persistence", LCRecordBatchLength(storedBatch) == 4 &&
+            LCRecordBatchFilterString(storedBatch, 0, anna, rows) == 2);
+  
+  LCMutableDictionaryRef mismatched = LCMutableDictionaryCreate(NULL, 0);
+  LCNumberRef seven = LCNumberCreateInteger(7);
+  LCMutableDictionarySetValueForKey(mismatched, nameKey, seven);
+  LCMutableDictionarySetValueForKey(mismatched, scoreKey, anna);
+  LCMutableArrayAddObject(records, mismatched);
+  objectRelease(mismatched);
+  LCRecordBatchRef coercedBatch = LCRecordBatchCreateFromDictionaries(records, fields, 3);
+  mu_assert("LCRecordBatch coerces mismatched cells", LCRecordBatchStringCodes(coercedBatch, 0)[4] == -1 &&
+            LCRecordBatchColumnType(coercedBatch, 2) == LCColumnString &&
+            LCRecordBatchStringCodes(coercedBatch, 2)[0] == -1 && LCRecordBatchStringCodes(coercedBatch, 2)[4] == 0);
+  objectRelease(coercedBatch);
+  LCMutableArrayAddObject(records, anna);
+  mu_assert("LCRecordBatch rejects rows that are not dictionaries",
+            LCRecordBatchCreateFromDictionaries(records, fields, 3) == NULL);
   return 0;
 }
 
@@ -226,6 +841,18 @@ static char* test_data() {
   return 0;
 }
 
+static LCStoreRef prefetchStore;
+static LCInteger prefetchBatches;
+static LCInteger prefetchReads;
+
+static void prefetchReadMany(void *cookie, LCTypeRef types[], char *keys[], FILE *fds[], size_t length) {
+  prefetchBatches++;
+  for (LCInteger i=0; i<length; i++) {
+    fds[i] = storeReadData(prefetchStore, types[i], keys[i]);
+    prefetchReads++;
+  }
+}
+
 static char* test_object_persistence_with_store(LCStoreRef store, char *storeType) {
   LCContextRef context = contextCreate(store, NULL, 0);
   
@@ -237,10 +864,25 @@ static char* test_object_persistence_with_store(LCStoreRef store, char *storeTyp
   objectDeleteCache(test, context);
   mu_assert("string persistence", LCStringEqualCString(test, string));
   
+  char binaryChars[] = {'a', '\0', '"', '\\', '\n', 'b', '\0'};
+  LCStringRef binary = LCStringCreateFromChars(binaryChars, sizeof(binaryChars));
+  LCArrayRef binaryArray = LCArrayCreate(&binary, 1);
+  objectStore(binary, context);
+  objectDeleteCache(binary, context);
+  objectStoreAsComposite(binaryArray, context);
+  objectDeleteCache(binaryArray, context);
+  LCStringRef composedBinary = LCArrayObjectAtIndex(binaryArray, 0);
+  mu_assert("strings with NULs, quotes and backslashes persist", LCStringLength(binary) == sizeof(binaryChars) &&
+            memcmp(LCStringChars(binary), binaryChars, sizeof(binaryChars)) == 0 &&
+            LCStringLength(composedBinary) == sizeof(binaryChars) &&
+            memcmp(LCStringChars(composedBinary), binaryChars, sizeof(binaryChars)) == 0);
+  objectRelease(binaryArray);
+  objectRelease(binary);
+  
   char hash[HASH_LENGTH];
   objectHash(test, hash);
   FILE *fd = storeReadData(store, LCTypeString, hash);
-  LCStringRef stringFromFile = objectCreateFromFile(context, fd);
+  LCStringRef stringFromFile = objectCreateFromFile(context, LCTypeString, fd);
   mu_assert("objectCreateFromFile", LCStringEqualCString(stringFromFile, string));
 
   LCStringRef string1 = LCStringCreate("abc");
@@ -254,6 +896,164 @@ static char* test_object_persistence_with_store(LCStoreRef store, char *storeTyp
   mu_assert("array persistence", LCStringEqual(string1, strings[0]) && LCStringEqual(string2, strings[1]) &&
             LCStringEqual(string3, strings[2]));
   
+  LCMutableArrayRef prefetchStrings = LCMutableArrayCreate(NULL, 0);
+  for (LCInteger i=0; i<20; i++) {
+    char buffer[32];
+    sprintf(buffer, "prefetch %ld", (long)i);
+    LCStringRef prefetchString = LCStringCreate(buffer);
+    LCMutableArrayAddObject(prefetchStrings, prefetchString);
+    objectRelease(prefetchString);
+  }
+  LCArrayRef prefetchArray = LCMutableArrayCreateArray(prefetchStrings);
+  objectRelease(prefetchStrings);
+  objectStore(prefetchArray, context);
+  objectDeleteCache(prefetchArray, context);
+  prefetchStore = store;
+  prefetchBatches = 0;
+  prefetchReads = 0;
+  storeSetReadMany(store, prefetchReadMany);
+  objectPrefetch(prefetchArray, 1);
+  storeSetReadMany(store, NULL);
+  // the array's meta side record is read in the array's batch
+  mu_assert("objectPrefetch", prefetchBatches == 2 && prefetchReads == 22 &&
+            LCStringEqualCString(LCArrayObjectAtIndex(prefetchArray, 19), "prefetch 19"));
+  objectRelease(prefetchArray);
+  
+  LCMutableArrayRef cachedStrings = LCMutableArrayCreate(NULL, 0);
+  for (LCInteger i=0; i<20; i++) {
+    char buffer[32];
+    sprintf(buffer, "cache %ld", (long)i);
+    LCStringRef cachedString = LCStringCreate(buffer);
+    LCMutableArrayAddObject(cachedStrings, cachedString);
+    objectRelease(cachedString);
+  }
+  LCArrayRef cachedArray = LCMutableArrayCreateArray(cachedStrings);
+  objectRelease(cachedStrings);
+  objectStore(cachedArray, context);
+  objectDeleteCache(cachedArray, context);
+  contextSetCacheBudget(context, 300);
+  bool cachedEqual = true;
+  for (LCInteger i=0; i<20; i++) {
+    char buffer[32];
+    sprintf(buffer, "cache %ld", (long)i);
+    cachedEqual = cachedEqual && LCStringEqualCString(LCArrayObjectAtIndex(cachedArray, i), buffer);
+  }
+  LCCacheStats stats = contextCacheStats(context);
+  mu_assert("cache budget", cachedEqual && stats.loads == 20 && stats.evictions > 0 && stats.resident < 20 &&
+            stats.used <= 300);
+  LCStringRef pinned = LCArrayObjectAtIndex(cachedArray, 0);
+  objectPin(pinned);
+  char *pinnedChars = LCStringChars(pinned);
+  for (LCInteger i=1; i<20; i++) {
+    LCStringLength(LCArrayObjectAtIndex(cachedArray, i));
+  }
+  stats = contextCacheStats(context);
+  mu_assert("cache refault and pin", stats.refaults > 0 && strcmp(pinnedChars, "cache 0") == 0);
+  objectUnpin(pinned);
+  LCStringRef slice = LCStringCreateSlice(LCArrayObjectAtIndex(cachedArray, 1), 0, 5);
+  for (LCInteger i=2; i<20; i++) {
+    LCStringEqualCString(LCArrayObjectAtIndex(cachedArray, i), "");
+  }
+  mu_assert("slices keep their parent loaded", strcmp(LCStringChars(slice), "cache") == 0);
+  objectRelease(slice);
+  LCObjectRef sortedStrings[21];
+  memcpy(sortedStrings, LCArrayObjects(cachedArray), sizeof(LCObjectRef) * 20);
+  LCStringRef callerPinned = sortedStrings[5];
+  sortedStrings[20] = callerPinned;
+  objectPin(callerPinned);
+  contextSetCacheBudget(context, 100);
+  objectsSort(sortedStrings, 21);
+  for (LCInteger i=0; i<40; i++) {
+    if (i % 20 != 5) {
+      LCStringChars(LCArrayObjectAtIndex(cachedArray, i % 20));
+    }
+  }
+  stats = contextCacheStats(context);
+  LCStringChars(callerPinned);
+  bool callerPinKept = contextCacheStats(context).refaults == stats.refaults;
+  mu_assert("sorting by key pins objects only while it runs", callerPinKept && stats.resident <= 2 &&
+            LCStringEqualCString(sortedStrings[0], "cache 0") && LCStringEqualCString(sortedStrings[20], "cache 9"));
+  objectUnpin(callerPinned);
+  contextSetCacheBudget(context, 300);
+  sortedStrings[20] = NULL;
+  objectsSort(sortedStrings, 21);
+  stats = contextCacheStats(context);
+  mu_assert("sorting by compare pins objects only while it runs", sortedStrings[0] == NULL &&
+            LCStringEqualCString(sortedStrings[1], "cache 0") && stats.used <= 300);
+  contextSetCacheBudget(context, 0);
+  objectRelease(cachedArray);
+  
+  LCStringRef sharedString = LCStringCreate("shared");
+  char sharedHash[HASH_LENGTH];
+  objectHash(sharedString, sharedHash);
+  LCStringRef sharedStrings[] = {sharedString, sharedString};
+  LCArrayRef sharedArray1 = LCArrayCreate(sharedStrings, 2);
+  LCArrayRef sharedArray2 = LCArrayCreate(sharedStrings, 1);
+  objectRelease(sharedString);
+  objectStore(sharedArray1, context);
+  objectDeleteCache(sharedArray1, context);
+  mu_assert("contexts don't share identities by default",
+            LCArrayObjectAtIndex(sharedArray1, 0) != LCArrayObjectAtIndex(sharedArray1, 1));
+  objectRelease(sharedArray1);
+  sharedArray1 = LCArrayCreate(sharedStrings, 2);
+  contextSetSharesIdentities(context, true);
+  objectStore(sharedArray1, context);
+  objectStore(sharedArray2, context);
+  objectDeleteCache(sharedArray1, context);
+  objectDeleteCache(sharedArray2, context);
+  uint64_t metaLength = 0;
+  mu_assert("reference meta", objectStubMeta(LCArrayObjectAtIndex(sharedArray1, 0), LCMetaLength, &metaLength) &&
+            metaLength == 6 && LCStringLength(LCArrayObjectAtIndex(sharedArray1, 0)) == 6);
+  char storedHash[HASH_LENGTH];
+  char rehashed[HASH_LENGTH];
+  objectHash(sharedArray1, storedHash);
+  FILE *storedFile = storeReadData(store, LCTypeArray, storedHash);
+  void *hashContext = createHashContext();
+  LCByte storedBytes[256];
+  size_t storedLength;
+  while ((storedLength = fread(storedBytes, 1, sizeof(storedBytes), storedFile)) > 0) {
+    updateHashContext(hashContext, storedBytes, storedLength);
+  }
+  fclose(storedFile);
+  finalizeHashContext(hashContext, rehashed);
+  mu_assert("stored bytes hash to their key", strcmp(storedHash, rehashed) == 0);
+  LCStringRef fruits[] = {LCStringCreate("apple"), LCStringCreate("banana")};
+  LCArrayRef fruitArray = LCArrayCreate(fruits, 2);
+  objectRelease(fruits[0]);
+  objectRelease(fruits[1]);
+  objectStore(fruitArray, context);
+  objectDeleteCache(fruitArray, context);
+  LCStringRef apple = LCArrayObjectAtIndex(fruitArray, 0);
+  LCStringRef banana = LCArrayObjectAtIndex(fruitArray, 1);
+  mu_assert("compare stubs without loading", objectCompare(apple, banana) == LCSmaller && !objectEqual(apple, banana) &&
+            objectStubMeta(apple, LCMetaLength, &metaLength) && metaLength == 5 &&
+            objectStubMeta(banana, LCMetaLength, &metaLength) && metaLength == 6);
+  objectRelease(fruitArray);
+  LCByte sameBytes[] = {1, 2, 3};
+  LCDataRef sameData1 = LCDataCreate(sameBytes, 3);
+  LCDataRef sameData2 = LCDataCreate(sameBytes, 3);
+  objectStore(sameData1, context);
+  char sameHash[HASH_LENGTH];
+  objectHash(sameData1, sameHash);
+  objectHash(sameData2, sameHash);
+  LCDataRef sameStub = objectCreateFromContext(context, LCTypeData, sameHash);
+  bool loadedEqual = objectEqual(sameData1, sameData2);
+  mu_assert("types without compare compare the same as stubs and loaded",
+            loadedEqual == (objectCompare(sameData1, sameData2) == LCEqual) &&
+            loadedEqual == objectEqual(sameData1, sameStub) &&
+            loadedEqual == (objectCompare(sameData1, sameStub) == LCEqual));
+  objectRelease(sameData1);
+  objectRelease(sameData2);
+  objectRelease(sameStub);
+  mu_assert("identity map", LCArrayObjectAtIndex(sharedArray1, 0) == LCArrayObjectAtIndex(sharedArray1, 1) &&
+            LCArrayObjectAtIndex(sharedArray1, 0) == LCArrayObjectAtIndex(sharedArray2, 0) &&
+            LCStringEqualCString(LCArrayObjectAtIndex(sharedArray2, 0), "shared"));
+  objectRelease(sharedArray1);
+  objectRelease(sharedArray2);
+  sharedString = LCStringCreateFromHash(context, sharedHash);
+  mu_assert("identity map removes deallocated objects", LCStringEqualCString(sharedString, "shared"));
+  objectRelease(sharedString);
+  
   LCKeyValueRef keyValue = LCKeyValueCreate(string1, array);
   objectStore(keyValue, context);
   objectDeleteCache(keyValue, context);
@@ -270,6 +1070,32 @@ static char* test_object_persistence_with_store(LCStoreRef store, char *storeTyp
   LCStringRef *strings1 = LCMutableArrayObjects(mArray);
   mu_assert("mutable array persistence", LCStringEqual(string1, strings1[0]) && LCStringEqual(string2, strings1[1]) &&
             LCStringEqual(string3, strings1[2]) && LCStringEqual(string1, strings1[3]));
+  LCMutableArrayRef grown = LCMutableArrayCreate(&string1, 1);
+  LCArrayRef grownHolder = LCArrayCreate(&grown, 1);
+  objectRelease(grown);
+  objectStore(grownHolder, context);
+  objectDeleteCache(grownHolder, context);
+  LCMutableArrayRef grownStub = LCArrayObjectAtIndex(grownHolder, 0);
+  LCMutableArrayAddObject(grownStub, string2);
+  objectStore(grownStub, context);
+  objectDeleteCache(grownStub, context);
+  mu_assert("mutable stubs don't answer reference meta", LCMutableArrayLength(grownStub) == 2);
+  objectRelease(grownHolder);
+  
+  LCMutableStringRef mString = LCMutableStringCreate("abc");
+  objectStore(mString, context);
+  objectDeleteCache(mString, context);
+  LCMutableStringAppend(mString, "def");
+  mu_assert("mutable string persistence", strcmp(LCMutableStringChars(mString), "abcdef") == 0);
+  
+  int64_t integers[] = {3, 1, 2};
+  LCTypedArrayRef typedArray = LCTypedArrayCreate(LCElementInt64, integers, 3);
+  objectStore(typedArray, context);
+  objectDeleteCache(typedArray, context);
+  int64_t *storedIntegers = LCTypedArrayValues(typedArray);
+  mu_assert("typed array persistence", LCTypedArrayLength(typedArray) == 3 &&
+            LCTypedArrayElementType(typedArray) == LCElementInt64 && storedIntegers[0] == 3 && storedIntegers[2] == 2);
+  mu_assert("typed arrays are mapped from files", LCTypedArrayIsMapped(typedArray) == (strcmp(storeType, "file") == 0));
   
   LCMutableArrayAddObject(mArray, LCStringCreate("test1"));
   objectStoreAsComposite(mArray, context);
@@ -281,6 +1107,57 @@ static char* test_object_persistence_with_store(LCStoreRef store, char *storeTyp
   return 0;
 }
 
+struct graphDiffCounts {
+  LCInteger added;
+  LCInteger removed;
+  LCInteger changed;
+  bool changedPathCorrect;
+};
+
+static void graphDiffCount(void *cookie, LCDiffType diff, char *path, LCObjectRef object1, LCObjectRef object2) {
+  struct graphDiffCounts *counts = (struct graphDiffCounts*)cookie;
+  if (diff == LCDiffAdded) {
+    counts->added = counts->added + 1;
+  } else if (diff == LCDiffRemoved) {
+    counts->removed = counts->removed + 1;
+  } else {
+    counts->changed = counts->changed + 1;
+    counts->changedPathCorrect = strcmp(path, "objects/1")==0;
+  }
+}
+
+static char* test_graph_diff() {
+  LCMemoryStoreRef store = LCMemoryStoreCreate();
+  LCContextRef context = contextCreate(LCMemoryStoreStoreObject(store), NULL, 0);
+  LCStringRef string1 = LCStringCreate("abc");
+  LCStringRef string2 = LCStringCreate("def");
+  LCStringRef string2Changed = LCStringCreate("deg");
+  LCStringRef string3 = LCStringCreate("ghi");
+  LCStringRef strings1[] = {string1, string2, string3};
+  LCStringRef strings2[] = {string1, string2Changed, string3, string3};
+  LCArrayRef array1 = LCArrayCreate(strings1, 3);
+  LCArrayRef array2 = LCArrayCreate(strings2, 4);
+  objectStore(array1, context);
+  objectStore(array2, context);
+  
+  char hash1[HASH_LENGTH];
+  char hash2[HASH_LENGTH];
+  objectHash(array1, hash1);
+  objectHash(array2, hash2);
+  LCArrayRef stored1 = objectCreateFromContext(context, LCTypeArray, hash1);
+  LCArrayRef stored2 = objectCreateFromContext(context, LCTypeArray, hash2);
+  
+  struct graphDiffCounts counts = {0};
+  objectGraphDiff(stored1, stored2, &counts, graphDiffCount);
+  mu_assert("objectGraphDiff", counts.added == 1 && counts.removed == 0 && counts.changed == 1 &&
+            counts.changedPathCorrect);
+  
+  struct graphDiffCounts noCounts = {0};
+  objectGraphDiff(stored1, array1, &noCounts, graphDiffCount);
+  mu_assert("objectGraphDiff identical", noCounts.added == 0 && noCounts.removed == 0 && noCounts.changed == 0);
+  return 0;
+}
+
 static char* test_object_persistence() {
   LCMemoryStoreRef store = LCMemoryStoreCreate();
   char *memoryTest = test_object_persistence_with_store(LCMemoryStoreStoreObject(store), "memory");
@@ -291,6 +1168,7 @@ static char* test_object_persistence() {
   LCStringRef homeFolder = getHomeFolder();
   char *strings[] = {LCStringChars(homeFolder), "/testing/"};
   LCStringRef testPath = LCStringCreateFromStringArray(strings, 2);
+  deleteDirectory(LCStringChars(testPath));
   LCFileStoreRef fileStore = LCFileStoreCreate(LCStringChars(testPath));
   
   char *fileTest = test_object_persistence_with_store(LCFileStoreStoreObject(fileStore), "file");
@@ -300,14 +1178,24 @@ static char* test_object_persistence() {
 
 static char* all_tests() {
   mu_run_test(test_retain_counting);
+  mu_run_test(test_regions);
+  mu_run_test(test_release_modes);
+  mu_run_test(test_cycle_collection);
   mu_run_test(test_pipe);
   mu_run_test(test_memory_stream);
   mu_run_test(test_string);
+  mu_run_test(test_static_objects);
   mu_run_test(test_array);
+  mu_run_test(test_parallel_array);
+  mu_run_test(test_iterator);
   mu_run_test(test_dictionary);
+  mu_run_test(test_number);
+  mu_run_test(test_typed_array);
+  mu_run_test(test_record_batch);
   mu_run_test(test_sha1);
   mu_run_test(test_data);
   mu_run_test(test_object_persistence);
+  mu_run_test(test_graph_diff);
   return 0;
 }
 